@@ -0,0 +1,76 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <ctime>
+#include <algorithm>
+#include "http_types.h"
+#include "request_parser.h"
+
+namespace webdav {
+
+// 单个客户端连接的状态，由所属事件循环持有
+struct Connection {
+    int fd;
+    std::string peer;
+    std::vector<char> buffer;      // 已接收但尚未处理的数据
+    RequestParser parser;          // 增量解析 buffer 中的请求头
+    size_t header_size;            // 请求头长度（含结尾空行），0 表示尚未收齐
+    size_t content_length;
+    bool chunked;                  // 请求体使用 chunked 编码，长度由解码结果决定
+    size_t body_consumed;          // chunked 请求体已从 buffer 中解码掉的字节数（紧接请求头之后）
+    HTTPRequest request;
+    std::atomic<time_t> last_active;   // 工作线程处理完请求时更新，事件循环清理空闲连接时读取
+    std::atomic<bool> busy;        // 正由工作线程处理，事件循环不得触碰
+
+    Connection(int socket_fd, const std::string& peer_addr)
+        : fd(socket_fd), peer(peer_addr), header_size(0),
+          content_length(0), chunked(false), body_consumed(0), last_active(time(nullptr)), busy(false) {}
+
+    void reset() {
+        buffer.clear();
+        parser.reset();
+        header_size = 0;
+        content_length = 0;
+        chunked = false;
+        body_consumed = 0;
+        request.clear();
+    }
+
+    // 丢弃已处理完的请求（请求头和已缓冲的请求体），之后的数据是下一个流水线请求的开头
+    void consume_request() {
+        size_t body = chunked ? body_consumed
+                              : std::min(buffer.size() - header_size, content_length);
+        buffer.erase(buffer.begin(), buffer.begin() + header_size + body);
+        parser.reset();
+        header_size = 0;
+        content_length = 0;
+        chunked = false;
+        body_consumed = 0;
+        request.clear();
+    }
+};
+
+// epoll 事件循环：持有一个监听 socket 以及由它接受的全部客户端连接
+struct EventLoop {
+    int index;
+    int cpu;                       // 绑定的 CPU 核心，-1 表示不绑定
+    int epoll_fd;
+    int wake_fd;
+    int listen_fd;
+    std::thread thread;
+    std::map<int, std::shared_ptr<Connection>> connections;
+    std::mutex connections_mutex;
+
+    EventLoop() : index(0), cpu(-1), epoll_fd(-1), wake_fd(-1), listen_fd(-1) {}
+};
+
+} // namespace webdav
+
+#endif // EVENT_LOOP_H
@@ -8,6 +8,7 @@
 #include <atomic>
 #include <memory>
 #include <map>
+#include <functional>
 #include "http_types.h"
 #include "file_types.h"
 #include "logger.h"
@@ -15,20 +16,68 @@
 #include "http_parser.h"
 #include "file_manager.h"
 #include "xml_parser.h"
+#include "event_loop.h"
+#include "thread_pool.h"
 
 namespace webdav {
 
+struct ServerConfig {
+    size_t worker_threads;        // 工作线程数，0 表示按 CPU 核数
+    size_t max_queued_requests;   // 等待处理的请求上限，超出返回 503
+    size_t listeners;             // 事件循环数，大于 1 时各自使用 SO_REUSEPORT 监听并绑定核心，0 表示按 CPU 核数
+    bool propfind_infinity;       // 是否允许 Depth: infinity 的 PROPFIND，关闭时返回 403
+    int propfind_max_depth;       // Depth: infinity 时最多遍历的层数
+    size_t propfind_max_entries;  // 单个 PROPFIND 最多返回的条目数，超出时截断并标记 507
+    std::string property_store;   // PROPPATCH 设置的死属性的日志文件
+    size_t metadata_cache_bytes;  // 元数据和目录列表缓存的内存预算
+    size_t traversal_threads;     // 并行遍历目录树（PROPFIND、COPY、DELETE）的辅助线程数，0 表示不并行
+    DurabilityMode durability;    // PUT 写入的持久化策略
+    unsigned group_commit_us;     // 组提交额外等待同批写入的时间（微秒），0 表示只靠上一批同步的时间攒批
+
+    ServerConfig() : worker_threads(0), max_queued_requests(1024), listeners(1),
+                     propfind_infinity(true), propfind_max_depth(64), propfind_max_entries(100000),
+                     property_store("webdav_props.db"), metadata_cache_bytes(64 * 1024 * 1024),
+                     traversal_threads(4), durability(DurabilityMode::FSYNC), group_commit_us(0) {}
+};
+
 class WebDAVServer {
 public:
-    WebDAVServer(const std::string& host, int port, const std::string& root_path);
+    WebDAVServer(const std::string& host, int port, const std::string& root_path,
+                 const ServerConfig& config = ServerConfig());
     ~WebDAVServer();
 
     bool start();
     void stop();
 
+    // 工作线程池的队列深度、排队时间等统计
+    ThreadPool::Stats get_worker_stats();
+
 private:
-    void accept_connections();
-    void handle_client(int client_socket);
+    // 事件循环与连接管理
+    int create_listen_socket(bool reuse_port);
+    void destroy_event_loops();
+    void run_event_loop(EventLoop* loop);
+    void accept_connections(EventLoop* loop);
+    enum class ParseResult {
+        NEED_MORE,   // 请求尚未收齐
+        READY,       // 缓冲区中已有一个可处理的请求
+        FAILED       // 请求无效，已发送错误响应，需关闭连接
+    };
+
+    void handle_readable(EventLoop* loop, const std::shared_ptr<Connection>& conn);
+    ParseResult parse_buffered_request(const std::shared_ptr<Connection>& conn);
+    void process_connection(EventLoop* loop, const std::shared_ptr<Connection>& conn);
+    bool serve_request(const std::shared_ptr<Connection>& conn);
+    bool read_chunked_body(const std::shared_ptr<Connection>& conn, BodyReader& reader);
+    bool rearm_connection(EventLoop* loop, const std::shared_ptr<Connection>& conn);
+    void close_connection(EventLoop* loop, const std::shared_ptr<Connection>& conn);
+    void close_idle_connections(EventLoop* loop);
+    void reject_overloaded(EventLoop* loop, const std::shared_ptr<Connection>& conn);
+    void log_worker_stats();
+    bool send_response(int socket_fd, HTTPResponse& response);
+    bool send_all(int socket_fd, const char* data, size_t size, int flags = 0);
+    bool send_file(int socket_fd, int file_fd, size_t offset, size_t length);
+
     void handle_request(const HTTPRequest& request, HTTPResponse& response);
     
     // WebDAV 方法处理函数
@@ -45,22 +94,20 @@ private:
     void handle_lock_request(int client_socket);
     
     // 辅助函数
-    std::string build_xml_response(const std::string& uri, const FileInfo& info);
     std::string decode_url(const std::string& url);
     bool authenticate(const HTTPRequest& request);
     std::string format_http_date(time_t t);
-    std::string format_iso_date(time_t t);
 
     void send_error_response(int client_socket, int status_code, const std::string& status_message);
 
     std::string host_;
     int port_;
     std::string root_path_;
-    int server_socket_;
+    ServerConfig config_;
     std::atomic<bool> running_;
     
-    std::vector<std::thread> worker_threads_;
-    std::mutex threads_mutex_;
+    std::vector<std::unique_ptr<EventLoop>> loops_;
+    std::unique_ptr<ThreadPool> thread_pool_;
     
     std::unique_ptr<Logger> logger_;
     std::unique_ptr<AuthManager> auth_manager_;
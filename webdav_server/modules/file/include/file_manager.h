@@ -6,7 +6,17 @@
 #include <mutex>
 #include <map>
 #include <ctime>
+#include <functional>
+#include <sys/stat.h>
+#include <memory>
+#include <cstdint>
+#include <atomic>
 #include "file_types.h"
+#include "file_watcher.h"
+#include "property_store.h"
+#include "lru_cache.h"
+#include "tree_walker.h"
+#include "group_commit.h"
 
 namespace webdav {
 
@@ -14,44 +24,152 @@ class Logger;
 
 class FileManager {
 public:
-    FileManager(const std::string& root_path, Logger& logger);
+    static const size_t DEFAULT_CACHE_BYTES = 64 * 1024 * 1024;
+    static const size_t DEFAULT_TRAVERSAL_THREADS = 4;
+
+    struct CacheStats {
+        LruCacheStats info;      // 单个资源的元数据
+        LruCacheStats listing;   // 目录列表
+        LruCacheStats missing;   // 不存在的路径
+    };
+
+    // cache_bytes 为元数据、目录列表和不存在路径三个缓存共用的内存预算；
+    // traversal_threads 为所有目录遍历共用的辅助线程数，也是并行 COPY/DELETE 的常驻辅助线程数，
+    // 0 表示只在调用线程中进行
+    FileManager(const std::string& root_path, Logger& logger, size_t cache_bytes = DEFAULT_CACHE_BYTES,
+                size_t traversal_threads = DEFAULT_TRAVERSAL_THREADS);
     ~FileManager();
 
+    // 目录树操作中失败的成员：相对路径（COPY 为目标路径）和 errno
+    struct TreeFailure {
+        std::string path;
+        int error;
+    };
+
     bool create_directory(const std::string& path);
-    bool delete_resource(const std::string& path);
-    bool copy_resource(const std::string& src_path, const std::string& dest_path);
+    // 删除和复制目录树时，同一层的成员由常驻的辅助线程并行处理；全部成功时返回 true，
+    // 否则把失败的成员按先序记入 failures，因成员失败而连带失败的上级或下级不重复记录
+    bool delete_resource(const std::string& path, std::vector<TreeFailure>* failures = nullptr);
+    bool copy_resource(const std::string& src_path, const std::string& dest_path,
+                       std::vector<TreeFailure>* failures = nullptr);
     bool move_resource(const std::string& src_path, const std::string& dest_path);
     bool write_file(const std::string& path, const std::vector<char>& data);
     bool read_file(const std::string& path, std::vector<char>& data);
+    // 以只读方式打开文件，返回 fd 和当前大小，由调用方关闭
+    bool open_file(const std::string& path, int& fd, size_t& size);
     bool get_resource_info(const std::string& path, FileInfo& info);
     bool list_directory(const std::string& path, std::vector<FileInfo>& items);
-    bool set_properties(const std::string& path, const std::map<std::string, std::string>& properties);
+    // 分页列出目录：从 cursor（上一页返回的续读令牌，空串表示从头开始）处最多读取 limit 个子项，
+    // 读完整个目录时 cursor 置空。子项按名称排序，令牌由目录的设备号、inode 和本页最后一个名称组成，
+    // 不属于该目录的令牌返回 false。分页读取不经过目录缓存，内存占用只与 limit 有关
+    bool list_directory_page(const std::string& path, std::string& cursor, size_t limit,
+                             std::vector<FileInfo>& items);
+    // 遍历目录树，最多 max_depth 层，按名称排序的深度优先先序交给 visitor；
+    // 目录的读取和 stat 由 TreeWalker 并行进行。不进入指向目录的符号链接，遍历结果不写入缓存，
+    // 跳过 PUT 的临时文件；无法读取的子目录交给 on_error，见 TreeWalker::run
+    bool walk_directory(const std::string& path, int max_depth, const WalkVisitor& visitor,
+                        const WalkErrorVisitor& on_error = WalkErrorVisitor());
+    // 打开死属性日志，之后的属性修改会持久化，并随 MOVE/COPY/DELETE 一起迁移
+    bool open_property_store(const std::string& log_path);
+    // 原子地设置和删除 path 的若干死属性（属性名为 Clark 记法）
+    bool update_properties(const std::string& path, const std::map<std::string, std::string>& set,
+                           const std::vector<std::string>& remove);
     bool get_properties(const std::string& path, std::map<std::string, std::string>& properties);
+    CacheStats get_cache_stats();
+    // 写入完成后的持久化策略，group_commit_us 为组提交额外等待同批写入的时间
+    void set_durability(DurabilityMode mode, unsigned group_commit_us);
 
     bool write_file_direct(const std::string& path, const std::vector<char>& data, size_t offset = 0);
-    bool write_file_stream(const std::string& path, int* fd_out = nullptr);
-    bool finish_write(const std::string& path, int fd);
+    // 流式写入：write_file_stream 在目标目录中打开临时文件（优先用 O_TMPFILE 创建匿名文件，
+    // 崩溃时不留下残余），expected_size 非零时预先分配空间；write_stream_data 逐块写入，
+    // finish_write 同步后把文件原子地发布到目标，abort_write 丢弃临时文件
+    bool write_file_stream(const std::string& path, FileWriter& writer, size_t expected_size = 0);
+    bool write_stream_data(FileWriter& writer, const char* data, size_t size);
+    bool finish_write(FileWriter& writer);
+    void abort_write(FileWriter& writer);
 
 private:
     std::string normalize_path(const std::string& path);
     std::string get_absolute_path(const std::string& relative_path);
     bool check_path_security(const std::string& path);
-    std::string generate_etag(const std::string& path);
+    // 属性存储中的键：以 / 开头的规范化相对路径
+    std::string property_key(const std::string& path);
+    // 由已有的 stat 结果生成属性和 ETag，不再额外访问文件系统
+    void fill_file_info(const std::string& path, const struct stat& st, FileInfo& info);
+    // 监视 abs_path 所在目录（目录本身也一并监视），返回其缓存项能否依赖 inotify 失效
+    bool watch_entry(const std::string& abs_path, bool is_directory);
+    // abs_path 发生变化，连同父目录的属性和列表一起失效；subtree 为 true 时其下所有内容也失效
+    // （只有目录需要，子树分散在各个分片中，需要扫描整个缓存）；空路径表示全部失效
+    void invalidate(const std::string& abs_path, bool subtree);
+    // 按持久化策略把写入的文件同步到磁盘
+    bool sync_file(int fd);
+    // 按持久化策略同步 abs_path 所在的目录，使新建或替换的目录项本身也能落盘
+    bool sync_parent_directory(const std::string& abs_path);
+    // 把写完的临时文件原子地发布到目标路径，失败时设置 errno
+    bool publish_file(FileWriter& writer);
+    
+    struct TreeEntry {
+        std::string path;       // 相对服务根目录的路径
+        std::string relative;   // 相对遍历起点的路径
+        std::string name;
+        bool is_directory;
+        int depth;       // 直接子项为 1
+        size_t parent;   // 所在目录在列表中的下标，直接子项为 NO_PARENT
+    };
+    static const size_t NO_PARENT = static_cast<size_t>(-1);
+    class DirectoryHandle;
+    // walk_directory 的实现，不跳过 PUT 的临时文件
+    bool walk_tree(const std::string& path, int max_depth, const WalkVisitor& visitor,
+                   const WalkErrorVisitor& on_error = WalkErrorVisitor());
+    // 按先序列出 path 下的整棵树，包括 PUT 的临时文件（DELETE 需要一并删除）
+    void collect_tree(const std::string& path, std::vector<TreeEntry>& entries);
+    // 并行处理 indices 中的成员：fn 收到成员所在目录在源树（src_root 之下）和目标树（dest_root 之下，
+    // 为 -1 时不打开）中的句柄，打开失败时为 -1 且 errno 已设置。同一目录下的成员共用句柄，
+    // 对子项只需按名称 *at 操作，不再为每个成员拼接和解析完整路径
+    void for_each_parallel(const std::vector<TreeEntry>& entries, const std::vector<size_t>& indices,
+                           int src_root, int dest_root,
+                           const std::function<void(size_t index, int src_dir, int dest_dir)>& fn);
 
     std::string root_path_;
     Logger& logger_;
+    bool use_uring_;   // 内核支持 io_uring 时流式写入走异步队列
     std::mutex file_mutex_;
     std::map<std::string, std::mutex> path_mutexes_;
     std::mutex path_mutexes_mutex_;
 
+    // 元数据和目录列表缓存：所在目录处于 inotify 监视下的条目一直有效直到收到变化事件，
+    // 无法监视的条目（inotify 不可用或超出监视数上限）退回按 CACHE_TTL 过期
     struct CacheEntry {
         FileInfo info;
         time_t cache_time;
+        bool watched;
+    };
+    
+    // 列表以只读共享指针存放：命中时在缓存锁内只复制指针，条目复制在锁外进行
+    struct DirCacheEntry {
+        std::shared_ptr<const std::vector<FileInfo>> items;
+        time_t cache_time;
+        bool watched;
+    };
+    
+    // 不存在的路径：客户端反复探测的 desktop.ini、Thumbs.db、~$ 锁文件等直接从这里返回，
+    // 在该路径被创建（本进程的修改或 inotify 事件）时失效
+    struct MissingEntry {
+        time_t cache_time;
+        bool watched;
     };
     
-    std::map<std::string, CacheEntry> cache_;
-    std::mutex cache_mutex_;
-    static const int CACHE_TTL = 5; // 缓存有效期（秒）
+    ShardedLruCache<CacheEntry> cache_;
+    ShardedLruCache<DirCacheEntry> dir_cache_;   // 不分片：大目录的列表可用满整个列表预算
+    ShardedLruCache<MissingEntry> missing_;
+    std::unique_ptr<FileWatcher> watcher_;
+    std::unique_ptr<PropertyStore> properties_;
+    DurabilityMode durability_;
+    std::unique_ptr<GroupCommit> group_commit_;
+    size_t traversal_threads_;
+    std::atomic<int> traversal_permits_;   // 尚可启动的遍历辅助线程数
+    std::unique_ptr<HelperPool> tree_helpers_;   // 并行 COPY/DELETE 的常驻辅助线程
+    static const int CACHE_TTL = 5; // 未监视条目的缓存有效期（秒）
 };
 
 } // namespace webdav
@@ -18,6 +18,18 @@ struct FileInfo {
     std::map<std::string, std::string> properties;
 };
 
+// 流式写入中的文件：先写同目录下的临时文件，完成后原子替换目标
+struct FileWriter {
+    int fd;
+    std::string path;        // 目标文件绝对路径
+    std::string temp_path;   // 有名临时文件的绝对路径，O_TMPFILE 创建的匿名文件为空
+    size_t offset;           // 下一次写入的位置
+    size_t preallocated;     // 按 Content-Length 预分配的字节数
+    bool async;              // 通过当前线程的 io_uring 队列异步写入
+
+    FileWriter() : fd(-1), offset(0), preallocated(0), async(false) {}
+};
+
 } // namespace webdav
 
 #endif // FILE_TYPES_H 
\ No newline at end of file
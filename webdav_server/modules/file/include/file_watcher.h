@@ -0,0 +1,51 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <functional>
+
+namespace webdav {
+
+class Logger;
+
+// 基于 inotify 监视目录变化，供元数据缓存失效使用
+// 回调参数为发生变化的绝对路径，其父目录的列表和属性也随之失效；subtree 为 true 时
+// 该路径是目录，其下所有内容都应视为已变化；空字符串表示事件队列溢出，所有缓存都应失效
+class FileWatcher {
+public:
+    typedef std::function<void(const std::string& path, bool subtree)> Callback;
+
+    FileWatcher(Logger& logger, const Callback& callback);
+    ~FileWatcher();
+
+    // inotify 不可用时返回 false，调用方应退回定时过期
+    bool start();
+    void stop();
+
+    // 监视目录 abs_dir 的直接子项，返回该目录当前是否处于监视中
+    bool watch(const std::string& abs_dir);
+
+private:
+    void run();
+    void handle_event(int wd, uint32_t mask, const char* name);
+    // 移除 dir 及其下所有子目录的监视（目录被删除或移走后原路径不再有效）
+    void forget_tree(const std::string& dir);
+
+    Logger& logger_;
+    Callback callback_;
+    int inotify_fd_;
+    int wake_fd_;
+    std::thread thread_;
+
+    std::mutex mutex_;
+    std::map<int, std::string> wd_paths_;
+    std::map<std::string, int> path_wds_;
+    bool limit_reported_;
+};
+
+} // namespace webdav
+
+#endif // FILE_WATCHER_H
@@ -0,0 +1,53 @@
+#ifndef GROUP_COMMIT_H
+#define GROUP_COMMIT_H
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <sys/types.h>
+
+namespace webdav {
+
+// 写入完成后的持久化策略
+enum class DurabilityMode {
+    FSYNC,          // 每个文件返回前各自 fsync（默认）
+    GROUP_COMMIT,   // 一个时间窗口内完成的写入合并为每个文件系统一次 syncfs
+    NONE            // 不主动同步，由内核按自己的节奏回写，适合临时共享
+};
+
+// 组提交：第一个到达的写入成为本批的领头者，等上一批同步完成（以及可选的时间窗口）后关闭本批，
+// 统一同步后其余写入只取结果。同一时刻只有一批在同步，同步期间到达的写入自然组成下一批，
+// 并发越高每批越大；没有并发时只比 fsync 多一次加锁
+// 同步方式取决于内核：5.8 起 syncfs 会报告文件系统上的回写错误，每批对涉及的每个文件系统调用一次，
+// 代价是同一文件系统上其他进程的脏数据也被一起刷下去；更早的内核上 syncfs 即使回写失败也返回成功，
+// 退回由领头者对批内每个文件逐个 fsync，只省去各线程分别等待
+class GroupCommit {
+public:
+    // window_us 为领头者额外等待同批写入的时间，0 表示只靠上一批同步的时间攒批
+    explicit GroupCommit(unsigned window_us);
+
+    // 等待 fd 的数据随所在批次落盘，失败时返回 false 并设置 errno
+    bool sync(int fd);
+
+private:
+    struct Batch {
+        std::vector<dev_t> devices;   // 与 fds 一一对应
+        std::vector<int> fds;   // 批内文件的句柄，其所有者在批次完成前一直等待
+        bool done;
+        int error;
+
+        Batch() : done(false), error(0) {}
+    };
+
+    unsigned window_us_;
+    bool use_syncfs_;   // 内核的 syncfs 能报告回写错误
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::shared_ptr<Batch> current_;   // 正在收集的批次
+    bool syncing_;                     // 有一批正在同步
+};
+
+} // namespace webdav
+
+#endif // GROUP_COMMIT_H
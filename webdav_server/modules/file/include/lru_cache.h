@@ -0,0 +1,185 @@
+#ifndef LRU_CACHE_H
+#define LRU_CACHE_H
+
+#include <string>
+#include <list>
+#include <iterator>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+namespace webdav {
+
+struct LruCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;   // 因超出内存预算被淘汰的条目数
+    size_t entries;
+    size_t bytes;         // 条目占用内存的估计值
+    size_t capacity;
+};
+
+// 按路径哈希分片的 LRU 缓存：每个分片各有一把锁和一份内存预算，超出预算时淘汰最久未用的条目
+// generation() 在每次失效前递增，调用方在查询文件系统前记下它，写入时用 put_if_current
+// 发现期间是否有过失效，避免把已过期的结果当作最新结果缓存
+template <typename Value>
+class ShardedLruCache {
+public:
+    explicit ShardedLruCache(size_t capacity_bytes, size_t shard_count = 16)
+        : capacity_(capacity_bytes), generation_(0), hits_(0), misses_(0), evictions_(0) {
+        for (size_t i = 0; i < shard_count; ++i) {
+            shards_.emplace_back(new Shard(capacity_bytes / shard_count));
+        }
+    }
+
+    uint64_t generation() const { return generation_.load(std::memory_order_acquire); }
+
+    // 命中时把条目移到最近使用的位置
+    bool get(const std::string& key, Value& value) {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        value = it->second->value;
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // bytes 为条目占用内存的估计值，超过单个分片预算的条目不缓存
+    void put(const std::string& key, Value value, size_t bytes) {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        insert(shard, key, std::move(value), bytes);
+    }
+
+    // 自 generation 以来没有发生过失效时写入并返回 true，否则不写入
+    bool put_if_current(const std::string& key, Value value, size_t bytes, uint64_t generation) {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (generation_.load(std::memory_order_acquire) != generation) {
+            return false;
+        }
+        insert(shard, key, std::move(value), bytes);
+        return true;
+    }
+
+    void erase(const std::string& key) {
+        generation_.fetch_add(1, std::memory_order_acq_rel);
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            remove(shard, it->second);
+        }
+    }
+
+    // 删除 path 本身及其下所有路径；子树分散在各个分片中，需要逐个分片扫描
+    void erase_tree(const std::string& path) {
+        generation_.fetch_add(1, std::memory_order_acq_rel);
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            for (auto it = shard->lru.begin(); it != shard->lru.end(); ) {
+                const std::string& key = it->key;
+                if (key.compare(0, path.size(), path) == 0 &&
+                    (key.size() == path.size() || key[path.size()] == '/')) {
+                    shard->index.erase(key);
+                    shard->bytes -= it->bytes;
+                    it = shard->lru.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    void clear() {
+        generation_.fetch_add(1, std::memory_order_acq_rel);
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->index.clear();
+            shard->lru.clear();
+            shard->bytes = 0;
+        }
+    }
+
+    LruCacheStats get_stats() {
+        LruCacheStats stats = LruCacheStats();
+        stats.hits = hits_.load(std::memory_order_relaxed);
+        stats.misses = misses_.load(std::memory_order_relaxed);
+        stats.evictions = evictions_.load(std::memory_order_relaxed);
+        stats.capacity = capacity_;
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            stats.entries += shard->index.size();
+            stats.bytes += shard->bytes;
+        }
+        return stats;
+    }
+
+private:
+    struct Node {
+        std::string key;
+        Value value;
+        size_t bytes;
+    };
+
+    struct Shard {
+        explicit Shard(size_t budget) : budget(budget), bytes(0) {}
+
+        std::mutex mutex;
+        std::list<Node> lru;   // 表头为最近使用
+        std::unordered_map<std::string, typename std::list<Node>::iterator> index;
+        size_t budget;
+        size_t bytes;
+    };
+
+    Shard& shard_for(const std::string& key) {
+        return *shards_[std::hash<std::string>()(key) % shards_.size()];
+    }
+
+    void insert(Shard& shard, const std::string& key, Value value, size_t bytes) {
+        bytes += key.size() * 2 + sizeof(Node) + 64;  // 键在链表和索引中各存一份，另加节点开销
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            remove(shard, it->second);
+        }
+        if (bytes > shard.budget) {
+            return;
+        }
+
+        shard.lru.push_front(Node{key, std::move(value), bytes});
+        shard.index[key] = shard.lru.begin();
+        shard.bytes += bytes;
+
+        while (shard.bytes > shard.budget) {
+            remove(shard, std::prev(shard.lru.end()));
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void remove(Shard& shard, typename std::list<Node>::iterator node) {
+        shard.bytes -= node->bytes;
+        shard.index.erase(node->key);
+        shard.lru.erase(node);
+    }
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    size_t capacity_;
+    std::atomic<uint64_t> generation_;
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> misses_;
+    std::atomic<uint64_t> evictions_;
+};
+
+} // namespace webdav
+
+#endif // LRU_CACHE_H
@@ -0,0 +1,71 @@
+#ifndef PROPERTY_STORE_H
+#define PROPERTY_STORE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cstddef>
+
+namespace webdav {
+
+class Logger;
+
+// 死属性的持久化存储：所有修改以带 CRC 的记录追加到日志文件，内存中保存完整的索引，
+// 查询不访问磁盘。启动时重放日志，末尾不完整的记录（写入中途崩溃）被截掉；
+// 废弃记录占比过高时把当前索引重写为新日志并原子替换，重写在锁外进行，不阻塞查询
+// 路径为服务根目录下的相对路径（以 / 开头），属性名为 Clark 记法 "{命名空间}本地名"
+class PropertyStore {
+public:
+    typedef std::map<std::string, std::string> PropertyMap;
+
+    explicit PropertyStore(Logger& logger);
+    ~PropertyStore();
+
+    // 打开（不存在时创建）日志文件并载入索引
+    bool open(const std::string& log_path);
+    bool is_open() const { return fd_ >= 0; }
+
+    // 取 path 的全部死属性，没有时返回 false
+    bool get(const std::string& path, PropertyMap& properties);
+    // 一次设置和删除若干属性，作为一条记录写入，要么全部生效要么全部不生效
+    bool update(const std::string& path, const PropertyMap& set, const std::vector<std::string>& remove);
+    // 删除 path 及其下所有路径的属性
+    bool remove_tree(const std::string& path);
+    // 用 src 的属性替换 dest 的属性（只涉及这一个路径）
+    bool copy(const std::string& src, const std::string& dest);
+    // 把 src 及其下所有路径的属性移到 dest 下，dest 原有的属性被丢弃
+    bool move_tree(const std::string& src, const std::string& dest);
+
+private:
+    // 读入日志并重放到索引
+    bool load(const std::string& log_path);
+    // 把记录写入日志并同步到磁盘，之后才修改索引；调用时须持有 mutex_
+    bool append(const std::string& record);
+    // 把一条记录应用到索引，记录格式错误时返回 false
+    bool replay(const char* data, size_t size);
+    // 废弃记录占比过高时压缩日志，调用时不得持有 mutex_
+    void maybe_compact();
+    // 把快照之后追加的记录接到已写好快照的临时文件 fd 末尾，并替换日志；调用时须持有 mutex_
+    bool compact(int fd, const std::string& temp_path, size_t compacted_size, size_t snapshot_end);
+    void set_entry(const std::string& path, const PropertyMap& properties);
+    // path 本身或其下是否有属性，调用时须持有 mutex_
+    bool has_tree(const std::string& path) const;
+    void erase_tree(const std::string& path);
+    void apply_update(const std::string& path, const PropertyMap& set, const std::vector<std::string>& remove);
+    void apply_copy(const std::string& src, const std::string& dest);
+    void apply_move_tree(const std::string& src, const std::string& dest);
+
+    Logger& logger_;
+    std::string log_path_;
+    int fd_;
+    size_t log_size_;    // 日志文件当前大小
+    size_t live_size_;   // 只保留当前索引时日志的大小，用于决定何时压缩
+    std::map<std::string, PropertyMap> entries_;
+    std::mutex mutex_;
+    bool compacting_;    // 正在锁外写入压缩后的日志，期间不再发起新的压缩
+};
+
+} // namespace webdav
+
+#endif // PROPERTY_STORE_H
@@ -0,0 +1,125 @@
+#ifndef TREE_WALKER_H
+#define TREE_WALKER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <sys/stat.h>
+#include "file_types.h"
+
+namespace webdav {
+
+// 目录遍历回调：depth 为相对起点的层级（直接子项为 1），返回 false 终止遍历
+typedef std::function<bool(const FileInfo& info, int depth)> WalkVisitor;
+// 无法打开或读取的目录：error 为对应的 errno，返回 false 终止遍历
+typedef std::function<bool(const FileInfo& info, int depth, int error)> WalkErrorVisitor;
+
+// 并行目录遍历：每个目录的读取是一个任务，条目多的目录再按块拆成 fstatat 任务；
+// 任务放在各线程自己的双端队列中，线程从自己队列的尾部取，空闲时从其他队列的头部窃取
+// 结果按名称排序后以深度优先的先序交给调用线程，顺序与线程数和调度无关；
+// 调用线程等待某个目录时也参与执行任务。已读取但尚未交给回调的条目数有上限，
+// 超出时暂缓读取新的目录，内存占用不随目录树的规模增长
+class TreeWalker {
+public:
+    // 由 stat 结果生成 FileInfo，在工作线程中调用
+    typedef std::function<void(const std::string& path, const struct stat& st, FileInfo& info)> InfoBuilder;
+
+    // root_fd 为起点目录的句柄（由遍历器接管并关闭），root_path 为起点的相对路径；
+    // permits 为所有遍历共享的辅助线程配额，每个辅助线程启动时取走一个，退出时归还
+    TreeWalker(int root_fd, const std::string& root_path, int max_depth,
+               std::atomic<int>& permits, size_t max_helpers, const InfoBuilder& build);
+    ~TreeWalker();
+
+    // 依次对每个条目调用 visitor，回调返回 false 时提前结束；无法读取的目录改为交给 on_error
+    // 且不进入，未提供 on_error 时按空目录交给 visitor
+    void run(const WalkVisitor& visitor, const WalkErrorVisitor& on_error = WalkErrorVisitor());
+
+private:
+    class Fd;
+    struct Node;
+    struct Task {
+        std::shared_ptr<Node> node;
+        size_t begin;   // begin == end 表示读取目录，否则 stat [begin, end) 的条目
+        size_t end;
+    };
+    struct Slot {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void worker(size_t slot);
+    // 从自己的队列尾部取任务，没有时从其他队列头部窃取
+    bool take(size_t slot, Task& task);
+    void push(size_t slot, const Task& task);
+    void execute(size_t slot, const Task& task);
+    void scan(size_t slot, const std::shared_ptr<Node>& node);
+    void stat_range(size_t slot, const std::shared_ptr<Node>& node, size_t begin, size_t end);
+    // 目录的全部条目 stat 完毕：为需要进入的子目录建立节点并安排读取，调用时须持有 mutex_
+    void finish(size_t slot, const std::shared_ptr<Node>& node);
+    // 预算允许时把暂缓的目录放入队列，调用时须持有 mutex_
+    void schedule_deferred(size_t slot);
+    // 等待节点读取完成，期间执行队列中的任务；节点尚未开始读取时由调用线程直接读取
+    void wait_ready(const std::shared_ptr<Node>& node);
+    void maybe_spawn_helper();
+
+    int max_depth_;
+    std::atomic<int>& permits_;
+    size_t max_helpers_;
+    InfoBuilder build_;
+
+    std::vector<std::unique_ptr<Slot>> slots_;   // 0 号为调用线程
+    std::vector<std::thread> helpers_;
+    std::shared_ptr<Node> root_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::shared_ptr<Node>> deferred_;   // 因预算暂缓读取的目录
+    size_t buffered_;          // 已读取但尚未交给回调的条目数
+    size_t idle_helpers_;
+    std::atomic<size_t> queued_;   // 各队列中的任务总数
+    bool stop_;
+};
+
+// 常驻的辅助线程组，用于目录树中彼此独立的成员上的批量操作：parallel_for 把作业挂到队列上，
+// 空闲的辅助线程和调用线程一起按块认领，不必每次批量操作都创建和回收线程；
+// 调用线程总会参与执行，辅助线程都在忙时退化为调用线程独自完成
+class HelperPool {
+public:
+    explicit HelperPool(size_t threads);
+    ~HelperPool();
+
+    // 把 [0, count) 按 chunk 分块执行 fn(begin, end)，全部完成后返回
+    void parallel_for(size_t count, size_t chunk, const std::function<void(size_t begin, size_t end)>& fn);
+
+private:
+    struct Job {
+        size_t count;
+        size_t chunk;
+        const std::function<void(size_t, size_t)>* fn;
+        std::atomic<size_t> next;   // 下一个未认领的块的起点
+        size_t active;              // 正在执行本作业的辅助线程数，由 mutex_ 保护
+    };
+
+    void worker();
+    // 认领并执行 job 的块直到取完
+    static void drain(Job& job);
+    // 从队列中移除 job，调用时须持有 mutex_
+    void remove(Job* job);
+
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable work_cv_;   // 有新作业或停止
+    std::condition_variable done_cv_;   // 有辅助线程离开作业
+    std::deque<Job*> jobs_;             // 还可能有未认领块的作业
+    bool stop_;
+};
+
+} // namespace webdav
+
+#endif // TREE_WALKER_H
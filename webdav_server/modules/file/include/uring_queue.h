@@ -0,0 +1,87 @@
+#ifndef URING_QUEUE_H
+#define URING_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+
+namespace webdav {
+
+// 基于 io_uring 的异步文件写入队列（编译时需定义 WEBDAV_HAVE_IO_URING）
+// 写入数据先拷贝到预先注册的固定缓冲区，SQE 只排入提交队列，等到需要空闲缓冲区或 drain/fsync 时
+// 连同等待完成一次 io_uring_enter 批量提交，调用方在磁盘写入期间可以继续接收网络数据；
+// fsync 以 IOSQE_IO_DRAIN 排在全部写入之后，与提交和等待完成合并为一次系统调用
+// 每个队列只能由一个线程使用
+class UringQueue {
+public:
+    static const size_t BUFFER_SIZE = 256 * 1024;
+    static const unsigned BUFFER_COUNT = 4;
+
+    ~UringQueue();
+
+    // 内核不支持 io_uring 或编译时未启用时返回 nullptr，reason 说明原因
+    static UringQueue* create(std::string& reason);
+
+    // 把数据拷贝到空闲缓冲区并排入写入；缓冲区全部占用时提交积压的写入并等待其中一个完成
+    bool write(int fd, const char* data, size_t size, off_t offset);
+    // 等待所有在途写入完成，返回这些写入是否全部成功
+    bool drain();
+    // 在所有在途写入之后执行 fsync 并等待完成
+    bool fsync(int fd);
+
+    bool registered_buffers() const { return registered_; }
+    // 最近一次失败的 errno
+    int error() const { return error_ != 0 ? error_ : last_error_; }
+
+private:
+    struct Slot {
+        bool busy;
+        int fd;
+        off_t offset;
+        size_t length;
+    };
+
+    UringQueue();
+    bool setup(std::string& reason);
+    // 在提交队列中填写一个 SQE，下一次 enter 时才交给内核
+    void queue(uint8_t opcode, int fd, unsigned slot, size_t length, off_t offset, uint8_t flags);
+    // 提交全部积压的 SQE 并等待至少 min_complete 个完成；失败时收回内核未取走的 SQE
+    bool enter(unsigned min_complete);
+    // 收回内核未取走的 SQE，对应的缓冲区不再占用
+    void retract_unsubmitted(int error);
+    // 处理完成队列中已有的全部 CQE，返回处理的个数
+    unsigned reap_ready();
+    void complete(uint64_t user_data, int32_t result);
+
+    int ring_fd_;
+    void* sq_ring_;
+    size_t sq_ring_size_;
+    void* cq_ring_;
+    size_t cq_ring_size_;
+    void* sqes_;
+    size_t sqes_size_;
+
+    unsigned* sq_head_;
+    unsigned* sq_tail_;
+    unsigned* sq_mask_;
+    unsigned* sq_array_;
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    unsigned* cq_mask_;
+    void* cqes_;
+
+    char* buffers_;
+    bool registered_;         // 缓冲区是否已注册为固定缓冲区（受 RLIMIT_MEMLOCK 限制）
+    Slot slots_[BUFFER_COUNT];
+    unsigned inflight_;       // 占用中的缓冲区数（已排入或已提交、尚未完成）
+    unsigned next_slot_;
+    int error_;               // 当前这批写入中的错误，drain 后清除
+    int last_error_;
+    bool fsync_done_;
+    int32_t fsync_result_;
+};
+
+} // namespace webdav
+
+#endif // URING_QUEUE_H
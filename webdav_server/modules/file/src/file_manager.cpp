@@ -1,25 +1,307 @@
 #include "file_manager.h"
 #include "logger.h"
+#include "uring_queue.h"
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <dirent.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/statvfs.h>
+#include <linux/fs.h>
+#include <sys/syscall.h>
+// openat2 需要 5.6 及以上内核的头文件，没有时只用 openat
+#if defined(__has_include)
+#if __has_include(<linux/openat2.h>)
+#include <linux/openat2.h>
+#define WEBDAV_HAVE_OPENAT2 1
+#endif
+#endif
 #include <fstream>
-#include <sstream>
 #include <cstring>
+#include <cerrno>
+#include <cstdio>
 #include <algorithm>
+#include <memory>
+#include <limits>
+#include <climits>
+#include <queue>
 
 namespace webdav {
 
-FileManager::FileManager(const std::string& root_path, Logger& logger)
-    : root_path_(root_path), logger_(logger) {
+namespace {
+
+// 缓存条目占用内存的估计值
+size_t info_bytes(const FileInfo& info) {
+    size_t bytes = sizeof(FileInfo) + info.name.size() + info.path.size() + info.etag.size();
+    for (const auto& prop : info.properties) {
+        bytes += 64 + prop.first.size() + prop.second.size();
+    }
+    return bytes;
+}
+
+const size_t TREE_OPERATION_CHUNK = 32;       // 并行删除和复制时每次认领的成员数
+const size_t MAX_PREALLOCATION = 1024UL * 1024 * 1024;   // PUT 按 Content-Length 预分配的上限
+const size_t PREALLOCATION_SHARE = 4;    // 预分配不超过剩余空间的 1/4
+const size_t COPY_BUFFER_SIZE = 1024 * 1024;   // 内核无法直接复制时 read/write 的缓冲区大小
+const char TEMP_PREFIX[] = ".tmp_put_";   // PUT 发布前的临时文件名前缀
+
+// PUT 的临时文件：发布前或进程崩溃后留下的都不是资源，不出现在列表中，也不随 COPY 复制
+bool is_temporary_name(const char* name) {
+    return strncmp(name, TEMP_PREFIX, sizeof(TEMP_PREFIX) - 1) == 0;
+}
+
+// 复制文件数据：先用 FICLONE 让目标共享源文件的数据块（btrfs、XFS 等写时复制文件系统上
+// 与文件大小无关），不支持时用 copy_file_range 在内核中复制，跨文件系统或内核过旧时
+// 从当前偏移处接着用大缓冲区 read/write 复制完剩余部分
+bool copy_file_contents(int src_dir, const char* src_name, int dest_dir, const char* dest_name) {
+    int src_fd = openat(src_dir, src_name, O_RDONLY | O_CLOEXEC);
+    if (src_fd < 0) {
+        return false;
+    }
+    int dest_fd = openat(dest_dir, dest_name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (dest_fd < 0) {
+        close(src_fd);
+        return false;
+    }
+    
+    bool done = false;
+    bool ok = true;
+#ifdef FICLONE
+    done = ioctl(dest_fd, FICLONE, src_fd) == 0;
+#endif
+    
+    while (!done) {
+        ssize_t copied = copy_file_range(src_fd, nullptr, dest_fd, nullptr, COPY_BUFFER_SIZE * 64, 0);
+        if (copied > 0) {
+            continue;
+        }
+        if (copied == 0) {
+            done = true;
+        } else if (errno != EINTR) {
+            // EXDEV、ENOSYS、EOPNOTSUPP 等：文件偏移停在已复制的位置，由下面的循环接着复制
+            break;
+        }
+    }
+    
+    if (!done) {
+        std::unique_ptr<char[]> buffer(new char[COPY_BUFFER_SIZE]);
+        while (ok) {
+            ssize_t n = read(src_fd, buffer.get(), COPY_BUFFER_SIZE);
+            if (n == 0) {
+                break;
+            }
+            if (n < 0) {
+                ok = errno == EINTR;
+                continue;
+            }
+            for (ssize_t written = 0; written < n && ok; ) {
+                ssize_t w = write(dest_fd, buffer.get() + written, n - written);
+                if (w > 0) {
+                    written += w;
+                } else if (w == 0 || errno != EINTR) {
+                    ok = false;
+                }
+            }
+        }
+    }
+    
+    close(src_fd);
+    return close(dest_fd) == 0 && ok;
+}
+
+// 复制遍历中的目录条目：真实目录在目标中新建（内容随后逐个复制）；指向目录的符号链接遍历时
+// 不会进入，按原样重建链接，不能变成一个空目录
+bool copy_directory_entry(int src_dir, int dest_dir, const char* name) {
+    struct stat st;
+    if (fstatat(src_dir, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        return false;
+    }
+    if (!S_ISLNK(st.st_mode)) {
+        return mkdirat(dest_dir, name, 0755) == 0;
+    }
+    
+    std::vector<char> target(st.st_size > 0 ? st.st_size + 1 : PATH_MAX);
+    ssize_t length = readlinkat(src_dir, name, target.data(), target.size());
+    if (length < 0) {
+        return false;
+    }
+    if (static_cast<size_t>(length) >= target.size()) {
+        errno = ENAMETOOLONG;   // 读取期间链接被替换成更长的目标
+        return false;
+    }
+    target[length] = '\0';
+    return symlinkat(target.data(), dest_dir, name) == 0;
+}
+
+// 打开 root_fd 之下的目录 relative：内核支持 openat2 时路径中不允许出现符号链接，也不能越出 root_fd，
+// 遍历之后有人把中间的目录换成符号链接也不会被带到树外；否则退回只检查最后一级的 openat
+int open_directory_beneath(int root_fd, const std::string& relative) {
+#if defined(WEBDAV_HAVE_OPENAT2) && defined(SYS_openat2)
+    struct open_how how;
+    memset(&how, 0, sizeof(how));
+    how.flags = O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC;
+    how.resolve = RESOLVE_BENEATH | RESOLVE_NO_SYMLINKS;
+    int fd = static_cast<int>(syscall(SYS_openat2, root_fd, relative.c_str(), &how, sizeof(how)));
+    if (fd >= 0 || errno != ENOSYS) {
+        return fd;
+    }
+#endif
+    return openat(root_fd, relative.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+}
+
+// 把 O_TMPFILE 创建的匿名文件链接到 target（target 已存在时失败，errno 为 EEXIST）；
+// 没有挂载 /proc 时改用 AT_EMPTY_PATH（需要 CAP_DAC_READ_SEARCH）
+bool link_anonymous_file(int fd, const std::string& target) {
+    char proc_path[64];
+    snprintf(proc_path, sizeof(proc_path), "/proc/self/fd/%d", fd);
+    if (linkat(AT_FDCWD, proc_path, AT_FDCWD, target.c_str(), AT_SYMLINK_FOLLOW) == 0) {
+        return true;
+    }
+    if (errno != ENOENT || access("/proc/self/fd", F_OK) == 0) {
+        return false;
+    }
+    return linkat(fd, "", AT_FDCWD, target.c_str(), AT_EMPTY_PATH) == 0;
+}
+
+std::string parent_directory(const std::string& abs_path) {
+    size_t slash = abs_path.find_last_of('/');
+    return slash == std::string::npos || slash == 0 ? std::string("/") : abs_path.substr(0, slash);
+}
+
+// 分页令牌 "设备号.inode.名称"：前两段为十六进制数，名称按字节十六进制编码，
+// 使令牌可以原样放入 HTTP 头
+std::string encode_page_token(const struct stat& dir_st, const std::string& name) {
+    static const char digits[] = "0123456789abcdef";
+    char prefix[48];
+    snprintf(prefix, sizeof(prefix), "%llx.%llx.",
+             static_cast<unsigned long long>(dir_st.st_dev),
+             static_cast<unsigned long long>(dir_st.st_ino));
+    std::string token = prefix;
+    for (unsigned char c : name) {
+        token += digits[c >> 4];
+        token += digits[c & 0x0f];
+    }
+    return token;
+}
+
+// 令牌属于 dir_st 所指目录且格式正确时取出名称
+bool decode_page_token(const std::string& token, const struct stat& dir_st, std::string& name) {
+    unsigned long long dev, ino;
+    int consumed = 0;
+    if (sscanf(token.c_str(), "%llx.%llx.%n", &dev, &ino, &consumed) != 2 || consumed == 0 ||
+        dev != static_cast<unsigned long long>(dir_st.st_dev) ||
+        ino != static_cast<unsigned long long>(dir_st.st_ino)) {
+        return false;
+    }
+    std::string hex = token.substr(consumed);
+    if (hex.empty() || hex.size() % 2 != 0) {
+        return false;
+    }
+    auto digit = [](char c) {
+        return c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+    };
+    name.clear();
+    for (size_t i = 0; i < hex.size(); i += 2) {
+        int high = digit(hex[i]);
+        int low = digit(hex[i + 1]);
+        if (high < 0 || low < 0 || (high == 0 && low == 0)) {
+            return false;
+        }
+        name += static_cast<char>(high << 4 | low);
+    }
+    return true;
+}
+
+// 每个线程一个 io_uring 队列，流式写入从打开到完成都在同一个工作线程中进行
+UringQueue* thread_uring_queue() {
+    static thread_local std::unique_ptr<UringQueue> queue;
+    static thread_local bool attempted = false;
+    if (!attempted) {
+        attempted = true;
+        std::string reason;
+        queue.reset(UringQueue::create(reason));
+    }
+    return queue.get();
+}
+
+} // namespace
+
+// 成员所在目录的句柄：成员按所在目录排序后，连续的成员多数在同一目录下，只在目录变化时重新打开
+class FileManager::DirectoryHandle {
+public:
+    explicit DirectoryHandle(int root_fd) : root_fd_(root_fd), fd_(-1), error_(0), opened_(false) {}
+    ~DirectoryHandle() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    // relative 为空表示树根
+    int get(const std::string& relative) {
+        if (relative.empty() || root_fd_ < 0) {
+            return root_fd_;
+        }
+        if (!opened_ || relative != relative_) {
+            if (fd_ >= 0) {
+                close(fd_);
+            }
+            fd_ = open_directory_beneath(root_fd_, relative);
+            error_ = fd_ < 0 ? errno : 0;
+            relative_ = relative;
+            opened_ = true;
+        }
+        errno = error_;
+        return fd_;
+    }
+
+private:
+    int root_fd_;
+    int fd_;
+    int error_;
+    bool opened_;
+    std::string relative_;
+};
+
+FileManager::FileManager(const std::string& root_path, Logger& logger, size_t cache_bytes,
+                         size_t traversal_threads)
+    : root_path_(root_path), logger_(logger), use_uring_(false),
+      cache_(cache_bytes * 7 / 16), dir_cache_(cache_bytes * 7 / 16, 1), missing_(cache_bytes / 8),
+      durability_(DurabilityMode::FSYNC), traversal_threads_(traversal_threads),
+      traversal_permits_(static_cast<int>(traversal_threads)) {
     if (mkdir(root_path.c_str(), 0755) != 0 && errno != EEXIST) {
         logger_.error("Failed to create root directory: " + root_path);
     }
+    
+    properties_.reset(new PropertyStore(logger_));
+    tree_helpers_.reset(new HelperPool(traversal_threads));
+    
+    // 目录变化由 inotify 通知，缓存不再需要定时过期
+    watcher_.reset(new FileWatcher(logger_, [this](const std::string& path, bool subtree) {
+        invalidate(path, subtree);
+    }));
+    if (watcher_->start()) {
+        logger_.info("Metadata cache invalidated by inotify");
+    } else {
+        logger_.warning("Metadata cache falls back to " + std::to_string(CACHE_TTL) + "s expiry");
+    }
+    
+    // 启动时探测一次 io_uring，不可用时流式写入使用普通的 write/fsync
+    std::string reason;
+    std::unique_ptr<UringQueue> probe(UringQueue::create(reason));
+    use_uring_ = probe != nullptr;
+    if (use_uring_) {
+        logger_.info(std::string("File writes use io_uring") +
+                     (probe->registered_buffers() ? " with registered buffers" : ""));
+    } else {
+        logger_.info("File writes use blocking I/O (" + reason + ")");
+    }
 }
 
-FileManager::~FileManager() {}
+FileManager::~FileManager() {
+    // 监视线程会回调 invalidate，须在缓存析构前停止
+    watcher_->stop();
+}
 
 std::string FileManager::normalize_path(const std::string& path) {
     std::string result = path;
@@ -46,15 +328,62 @@ bool FileManager::check_path_security(const std::string& path) {
     return abs_path.substr(0, norm_root.length()) == norm_root;
 }
 
-std::string FileManager::generate_etag(const std::string& path) {
-    struct stat st;
-    if (stat(path.c_str(), &st) != 0) {
-        return "";
+std::string FileManager::property_key(const std::string& path) {
+    return normalize_path("/" + path);
+}
+
+void FileManager::fill_file_info(const std::string& path, const struct stat& st, FileInfo& info) {
+    info.name = path.substr(path.find_last_of('/') + 1);
+    info.path = path;
+    info.size = st.st_size;
+    info.created_time = st.st_ctime;
+    info.modified_time = st.st_mtime;
+    info.accessed_time = st.st_atime;
+    info.is_directory = S_ISDIR(st.st_mode);
+    
+    char etag[48];
+    snprintf(etag, sizeof(etag), "\"%llx-%llx\"", static_cast<unsigned long long>(st.st_mtime),
+             static_cast<unsigned long long>(st.st_size));
+    info.etag = etag;
+    
+    // 死属性来自内存中的索引，不需要逐个文件读取
+    properties_->get(property_key(path), info.properties);
+}
+
+bool FileManager::watch_entry(const std::string& abs_path, bool is_directory) {
+    // 根目录的父目录在服务范围之外，根目录只依赖自身的监视
+    bool watched = normalize_path(abs_path) == normalize_path(root_path_) ||
+                   watcher_->watch(parent_directory(abs_path));
+    if (watched && is_directory) {
+        watched = watcher_->watch(abs_path);
+    }
+    return watched;
+}
+
+void FileManager::invalidate(const std::string& abs_path, bool subtree) {
+    if (abs_path.empty()) {
+        cache_.clear();
+        dir_cache_.clear();
+        missing_.clear();
+        return;
     }
     
-    std::stringstream ss;
-    ss << std::hex << st.st_mtime << "-" << st.st_size;
-    return "\"" + ss.str() + "\"";
+    // 路径可能刚被创建；移入的目录还会带来其下原本不存在的路径
+    if (subtree) {
+        cache_.erase_tree(abs_path);
+        dir_cache_.erase_tree(abs_path);
+        missing_.erase_tree(abs_path);
+    } else {
+        cache_.erase(abs_path);
+        dir_cache_.erase(abs_path);
+        missing_.erase(abs_path);
+    }
+    
+    // 父目录的修改时间随之变化，而父目录的属性又出现在祖父目录的列表中
+    std::string parent = parent_directory(abs_path);
+    cache_.erase(parent);
+    dir_cache_.erase(parent);
+    dir_cache_.erase(parent_directory(parent));
 }
 
 bool FileManager::create_directory(const std::string& path) {
@@ -64,45 +393,134 @@ bool FileManager::create_directory(const std::string& path) {
     }
     
     std::string abs_path = get_absolute_path(path);
-    return mkdir(abs_path.c_str(), 0755) == 0;
+    bool created = mkdir(abs_path.c_str(), 0755) == 0;
+    invalidate(abs_path, false);
+    return created;
 }
 
-bool FileManager::delete_resource(const std::string& path) {
-    if (!check_path_security(path)) {
+bool FileManager::delete_resource(const std::string& path, std::vector<TreeFailure>* failures) {
+    auto fail = [failures](const std::string& failed_path, int error) {
+        if (failures) {
+            failures->push_back(TreeFailure{failed_path, error});
+        }
         return false;
+    };
+    if (!check_path_security(path)) {
+        return fail(path, EACCES);
     }
     
     std::string abs_path = get_absolute_path(path);
     struct stat st;
     
-    if (stat(abs_path.c_str(), &st) != 0) {
-        return false;
+    if (lstat(abs_path.c_str(), &st) != 0) {
+        return fail(path, errno);
     }
+    invalidate(abs_path, S_ISDIR(st.st_mode));
     
-    if (S_ISDIR(st.st_mode)) {
-        DIR* dir = opendir(abs_path.c_str());
-        if (!dir) return false;
-        
-        struct dirent* entry;
-        while ((entry = readdir(dir)) != nullptr) {
-            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+    if (!S_ISDIR(st.st_mode)) {
+        if (unlink(abs_path.c_str()) != 0) {
+            return fail(path, errno);
+        }
+        properties_->remove_tree(property_key(path));
+        return true;
+    }
+    
+    // 先并行删除所有非目录条目，再从最深的一层起逐层并行删除目录；
+    // 成员删除失败时其所在的各级目录必然非空，跳过它们且不重复报告
+    int root_fd = open(abs_path.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (root_fd < 0) {
+        return fail(path, errno);
+    }
+    std::vector<TreeEntry> entries;
+    collect_tree(path, entries);
+    std::vector<int> errors(entries.size(), 0);
+    std::vector<unsigned char> blocked(entries.size(), 0);
+    std::vector<size_t> files;
+    std::vector<std::vector<size_t>> levels;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (!entries[i].is_directory) {
+            files.push_back(i);
+            continue;
+        }
+        if (levels.size() < static_cast<size_t>(entries[i].depth)) {
+            levels.resize(entries[i].depth);
+        }
+        levels[entries[i].depth - 1].push_back(i);
+    }
+    
+    bool root_blocked = false;
+    auto block_parents = [&](const std::vector<size_t>& indices) {
+        for (size_t index : indices) {
+            if (errors[index] == 0 && !blocked[index]) {
                 continue;
             }
-            
-            std::string sub_path = path + "/" + entry->d_name;
-            delete_resource(sub_path);
+            size_t parent = entries[index].parent;
+            while (parent != NO_PARENT && !blocked[parent]) {
+                blocked[parent] = 1;
+                parent = entries[parent].parent;
+            }
+            root_blocked = root_blocked || parent == NO_PARENT;
         }
-        
-        closedir(dir);
-        return rmdir(abs_path.c_str()) == 0;
-    } else {
-        return unlink(abs_path.c_str()) == 0;
+    };
+    
+    for_each_parallel(entries, files, root_fd, -1, [&](size_t index, int dir_fd, int) {
+        if ((dir_fd < 0 || unlinkat(dir_fd, entries[index].name.c_str(), 0) != 0) && errno != ENOENT) {
+            errors[index] = errno;
+        }
+    });
+    block_parents(files);
+    for (size_t level = levels.size(); level-- > 0; ) {
+        std::vector<size_t> removable;
+        for (size_t index : levels[level]) {
+            if (!blocked[index]) {
+                removable.push_back(index);
+            }
+        }
+        for_each_parallel(entries, removable, root_fd, -1, [&](size_t index, int dir_fd, int) {
+            // 指向目录的符号链接 AT_REMOVEDIR 失败后按普通文件删除
+            const char* name = entries[index].name.c_str();
+            if ((dir_fd < 0 || (unlinkat(dir_fd, name, AT_REMOVEDIR) != 0 &&
+                                (errno != ENOTDIR || unlinkat(dir_fd, name, 0) != 0))) && errno != ENOENT) {
+                errors[index] = errno;
+            }
+        });
+        block_parents(levels[level]);
+    }
+    close(root_fd);
+    // 删除期间的查询可能又缓存了子树中的条目
+    invalidate(abs_path, true);
+    
+    if (!root_blocked) {
+        if (rmdir(abs_path.c_str()) != 0) {
+            return fail(path, errno);
+        }
+        properties_->remove_tree(property_key(path));
+        return true;
     }
+    
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (errors[i] != 0) {
+            fail(entries[i].path, errors[i]);
+        } else if (!blocked[i]) {
+            properties_->remove_tree(property_key(entries[i].path));
+        }
+    }
+    return false;
 }
 
-bool FileManager::copy_resource(const std::string& src_path, const std::string& dest_path) {
-    if (!check_path_security(src_path) || !check_path_security(dest_path)) {
+bool FileManager::copy_resource(const std::string& src_path, const std::string& dest_path,
+                                std::vector<TreeFailure>* failures) {
+    auto fail = [failures](const std::string& failed_path, int error) {
+        if (failures) {
+            failures->push_back(TreeFailure{failed_path, error});
+        }
         return false;
+    };
+    if (!check_path_security(src_path)) {
+        return fail(src_path, EACCES);
+    }
+    if (!check_path_security(dest_path)) {
+        return fail(dest_path, EACCES);
     }
     
     std::string abs_src = get_absolute_path(src_path);
@@ -110,46 +528,107 @@ bool FileManager::copy_resource(const std::string& src_path, const std::string&
     
     struct stat st;
     if (stat(abs_src.c_str(), &st) != 0) {
-        return false;
+        return fail(src_path, errno);
     }
+    // 复制前后各失效一次：复制期间对目标的查询可能已把"不存在"写入缓存
+    invalidate(abs_dest, S_ISDIR(st.st_mode));
     
-    if (S_ISDIR(st.st_mode)) {
-        if (mkdir(abs_dest.c_str(), st.st_mode) != 0) {
-            return false;
+    if (!S_ISDIR(st.st_mode)) {
+        errno = 0;
+        bool copied = copy_file_contents(AT_FDCWD, abs_src.c_str(), AT_FDCWD, abs_dest.c_str());
+        int error = errno != 0 ? errno : EIO;
+        invalidate(abs_dest, false);
+        if (!copied) {
+            return fail(dest_path, error);
         }
-        
-        DIR* dir = opendir(abs_src.c_str());
-        if (!dir) return false;
-        
-        bool success = true;
-        struct dirent* entry;
-        while ((entry = readdir(dir)) != nullptr) {
-            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
-                continue;
+        properties_->copy(property_key(src_path), property_key(dest_path));
+        return true;
+    }
+    
+    if (mkdir(abs_dest.c_str(), st.st_mode) != 0) {
+        return fail(dest_path, errno);
+    }
+    properties_->copy(property_key(src_path), property_key(dest_path));
+    int src_root = open(abs_src.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    int dest_root = open(abs_dest.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (src_root < 0 || dest_root < 0) {
+        int error = errno;
+        if (src_root >= 0) {
+            close(src_root);
+        }
+        if (dest_root >= 0) {
+            close(dest_root);
+        }
+        invalidate(abs_dest, true);
+        return fail(dest_path, error);
+    }
+    
+    // 目录从浅到深逐层并行创建，上一层全部建好后再建下一层，最后并行复制所有文件；
+    // 目录创建失败时其下的成员不再尝试，也不重复报告
+    std::vector<TreeEntry> entries;
+    collect_tree(src_path, entries);
+    std::string src_prefix = src_path == "/" ? std::string() : src_path;
+    std::vector<std::string> dest_paths(entries.size());
+    std::vector<int> errors(entries.size(), 0);
+    std::vector<unsigned char> blocked(entries.size(), 0);
+    std::vector<size_t> files;
+    std::vector<std::vector<size_t>> levels;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        dest_paths[i] = dest_path + entries[i].path.substr(src_prefix.size());
+        if (!entries[i].is_directory) {
+            if (!is_temporary_name(entries[i].name.c_str())) {
+                files.push_back(i);
             }
-            
-            std::string sub_src = src_path + "/" + entry->d_name;
-            std::string sub_dest = dest_path + "/" + entry->d_name;
-            
-            if (!copy_resource(sub_src, sub_dest)) {
-                success = false;
-                break;
+            continue;
+        }
+        if (levels.size() < static_cast<size_t>(entries[i].depth)) {
+            levels.resize(entries[i].depth);
+        }
+        levels[entries[i].depth - 1].push_back(i);
+    }
+    
+    auto copy_entry = [&](size_t index, int src_dir, int dest_dir) {
+        const char* name = entries[index].name.c_str();
+        errno = 0;
+        bool copied = src_dir >= 0 && dest_dir >= 0 &&
+                      (entries[index].is_directory ? copy_directory_entry(src_dir, dest_dir, name)
+                                                   : copy_file_contents(src_dir, name, dest_dir, name));
+        if (!copied) {
+            errors[index] = errno != 0 ? errno : EIO;
+            blocked[index] = 1;
+            return;
+        }
+        properties_->copy(property_key(entries[index].path), property_key(dest_paths[index]));
+    };
+    // 所在目录创建失败的成员不再尝试
+    auto copy_members = [&](const std::vector<size_t>& members) {
+        std::vector<size_t> copyable;
+        for (size_t index : members) {
+            size_t parent = entries[index].parent;
+            if (parent != NO_PARENT && blocked[parent]) {
+                blocked[index] = 1;
+            } else {
+                copyable.push_back(index);
             }
         }
-        
-        closedir(dir);
-        return success;
-    } else {
-        std::ifstream src(abs_src, std::ios::binary);
-        std::ofstream dest(abs_dest, std::ios::binary);
-        
-        if (!src || !dest) {
-            return false;
+        for_each_parallel(entries, copyable, src_root, dest_root, copy_entry);
+    };
+    for (const auto& level : levels) {
+        copy_members(level);
+    }
+    copy_members(files);
+    close(src_root);
+    close(dest_root);
+    
+    invalidate(abs_dest, true);
+    
+    bool success = true;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (errors[i] != 0) {
+            success = fail(dest_paths[i], errors[i]);
         }
-        
-        dest << src.rdbuf();
-        return true;
     }
+    return success;
 }
 
 bool FileManager::move_resource(const std::string& src_path, const std::string& dest_path) {
@@ -219,12 +698,14 @@ bool FileManager::move_resource(const std::string& src_path, const std::string&
     
     // 尝试直接重命名
     if (rename(abs_src.c_str(), abs_dest.c_str()) == 0) {
-        // 清除缓存
-        {
-            std::lock_guard<std::mutex> lock(cache_mutex_);
-            cache_.erase(abs_src);
-            cache_.erase(abs_dest);
-            logger_.debug("Cleared cache entries for both source and destination");
+        // 清除缓存（inotify 事件是异步的，本进程的修改立即失效）
+        bool is_directory = S_ISDIR(src_stat.st_mode);
+        invalidate(abs_src, is_directory);
+        invalidate(abs_dest, is_directory);
+        logger_.debug("Cleared cache entries for both source and destination");
+        
+        if (!properties_->move_tree(property_key(src_path), property_key(dest_path))) {
+            logger_.error("Failed to move dead properties to " + dest_path);
         }
         
         logger_.info("Successfully moved resource");
@@ -286,18 +767,18 @@ bool FileManager::write_file(const std::string& path, const std::vector<char>& d
         remaining -= written;
     }
     
-    // 同步文件到磁盘
-    if (fsync(fd) < 0) {
+    // 按持久化策略同步文件及其目录项到磁盘
+    if (!sync_file(fd)) {
         logger_.error("Failed to sync file: " + std::string(strerror(errno)));
     }
     
     close(fd);
+    if (!sync_parent_directory(abs_path)) {
+        logger_.error("Failed to sync directory of " + abs_path + ": " + std::string(strerror(errno)));
+    }
     
     // 清除缓存
-    {
-        std::lock_guard<std::mutex> lock(cache_mutex_);
-        cache_.erase(abs_path);
-    }
+    invalidate(abs_path, false);
     
     logger_.info("Successfully wrote file: " + abs_path);
     return true;
@@ -324,6 +805,29 @@ bool FileManager::read_file(const std::string& path, std::vector<char>& data) {
     return true;
 }
 
+bool FileManager::open_file(const std::string& path, int& fd, size_t& size) {
+    if (!check_path_security(path)) {
+        return false;
+    }
+    
+    std::string abs_path = get_absolute_path(path);
+    fd = open(abs_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        logger_.error("Failed to open file: " + abs_path + " (" + strerror(errno) + ")");
+        return false;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        fd = -1;
+        return false;
+    }
+    
+    size = st.st_size;
+    return true;
+}
+
 bool FileManager::get_resource_info(const std::string& path, FileInfo& info) {
     if (!check_path_security(path)) {
         return false;
@@ -331,38 +835,54 @@ bool FileManager::get_resource_info(const std::string& path, FileInfo& info) {
     
     std::string abs_path = get_absolute_path(path);
     
-    // 检查缓存
-    {
-        std::lock_guard<std::mutex> lock(cache_mutex_);
-        auto it = cache_.find(abs_path);
-        if (it != cache_.end()) {
-            time_t now = time(nullptr);
-            if (now - it->second.cache_time < CACHE_TTL) {
-                info = it->second.info;
-                return true;
-            }
-            cache_.erase(it);
-        }
+    // 检查缓存；过期的条目在下面重新查询后被覆盖
+    CacheEntry cached;
+    if (cache_.get(abs_path, cached) &&
+        (cached.watched || time(nullptr) - cached.cache_time < CACHE_TTL)) {
+        info = std::move(cached.info);
+        return true;
     }
+    MissingEntry missing;
+    if (missing_.get(abs_path, missing) &&
+        (missing.watched || time(nullptr) - missing.cache_time < CACHE_TTL)) {
+        return false;
+    }
+    uint64_t generation = cache_.generation();
+    uint64_t missing_generation = missing_.generation();
     
+    // 先建立监视再 stat，之后发生的变化都会产生事件
+    bool watched = watch_entry(abs_path, false);
     struct stat st;
-    if (stat(abs_path.c_str(), &st) != 0) {
+    if (lstat(abs_path.c_str(), &st) != 0) {
+        if (errno == ENOENT) {
+            // 所在目录处于监视下时，该路径被创建会产生事件，否则只按 TTL 缓存
+            MissingEntry entry = {time(nullptr), watched};
+            if (!watched || !missing_.put_if_current(abs_path, entry, 0, missing_generation)) {
+                entry.watched = false;
+                missing_.put(abs_path, entry, 0);
+            }
+        }
         return false;
     }
+    if (S_ISLNK(st.st_mode)) {
+        // 符号链接目标的变化不会出现在所在目录的事件中
+        watched = false;
+        if (stat(abs_path.c_str(), &st) != 0) {
+            return false;
+        }
+    }
+    if (S_ISDIR(st.st_mode) && watched) {
+        // 目录的修改时间随子项变化，只有监视了目录本身才能长期缓存，监视后重新读取一次
+        watched = watch_entry(abs_path, true) && stat(abs_path.c_str(), &st) == 0;
+    }
+    fill_file_info(path, st, info);
     
-    info.name = path.substr(path.find_last_of('/') + 1);
-    info.path = path;
-    info.size = st.st_size;
-    info.created_time = st.st_ctime;
-    info.modified_time = st.st_mtime;
-    info.accessed_time = st.st_atime;
-    info.is_directory = S_ISDIR(st.st_mode);
-    info.etag = generate_etag(abs_path);
-    
-    // 更新缓存
-    {
-        std::lock_guard<std::mutex> lock(cache_mutex_);
-        cache_[abs_path] = {info, time(nullptr)};
+    // 更新缓存；查询期间有过失效时无法确定结果是否最新，只按 TTL 缓存
+    CacheEntry entry = {info, time(nullptr), watched};
+    size_t bytes = info_bytes(info);
+    if (!watched || !cache_.put_if_current(abs_path, entry, bytes, generation)) {
+        entry.watched = false;
+        cache_.put(abs_path, std::move(entry), bytes);
     }
     
     return true;
@@ -374,61 +894,294 @@ bool FileManager::list_directory(const std::string& path, std::vector<FileInfo>&
     }
     
     std::string abs_path = get_absolute_path(path);
+    DirCacheEntry cached;
+    if (dir_cache_.get(abs_path, cached) &&
+        (cached.watched || time(nullptr) - cached.cache_time < CACHE_TTL)) {
+        items.insert(items.end(), cached.items->begin(), cached.items->end());
+        return true;
+    }
+    uint64_t generation = cache_.generation();
+    uint64_t dir_generation = dir_cache_.generation();
+    
+    bool watched = watcher_->watch(abs_path);
     DIR* dir = opendir(abs_path.c_str());
     
     if (!dir) {
         return false;
     }
     
+    // 相对目录句柄 fstatat 每个子项：路径检查只做一次，每个子项只有一次 stat
+    int dir_fd = dirfd(dir);
+    std::string prefix = path == "/" ? std::string() : path;
+    std::vector<FileInfo> listing;
+    std::vector<bool> child_watched;
     struct dirent* entry;
     while ((entry = readdir(dir)) != nullptr) {
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0 ||
+            is_temporary_name(entry->d_name)) {
             continue;
         }
         
-        FileInfo info;
-        std::string sub_path = path + "/" + entry->d_name;
+        // 子目录的修改时间随其内容变化，需先监视子目录本身；符号链接的目标不在监视范围内，
+        // 它和 d_type 未知的条目只按 TTL 缓存
+        bool known_type = entry->d_type != DT_UNKNOWN && entry->d_type != DT_LNK;
+        bool cacheable = watched && known_type &&
+                         (entry->d_type != DT_DIR || watcher_->watch(abs_path + "/" + entry->d_name));
+        
+        struct stat st;
+        if (fstatat(dir_fd, entry->d_name, &st, 0) != 0) {
+            continue;
+        }
         
-        if (get_resource_info(sub_path, info)) {
-            items.push_back(info);
+        FileInfo info;
+        fill_file_info(prefix + "/" + entry->d_name, st, info);
+        listing.push_back(info);
+        child_watched.push_back(cacheable);
+    }
+    
+    closedir(dir);
+    items.insert(items.end(), listing.begin(), listing.end());
+    
+    // 列表和各子项的属性写入缓存；查询期间有过失效时只按 TTL 缓存
+    time_t now = time(nullptr);
+    size_t listing_bytes = sizeof(DirCacheEntry);
+    for (size_t i = 0; i < listing.size(); ++i) {
+        CacheEntry entry = {listing[i], now, child_watched[i]};
+        size_t bytes = info_bytes(listing[i]);
+        std::string child_path = abs_path + "/" + listing[i].name;
+        if (!entry.watched || !cache_.put_if_current(child_path, entry, bytes, generation)) {
+            entry.watched = false;
+            cache_.put(child_path, std::move(entry), bytes);
         }
+        listing_bytes += bytes;
+    }
+    DirCacheEntry dir_entry = {std::make_shared<const std::vector<FileInfo>>(std::move(listing)), now, watched};
+    if (!watched || !dir_cache_.put_if_current(abs_path, dir_entry, listing_bytes, dir_generation)) {
+        dir_entry.watched = false;
+        dir_cache_.put(abs_path, std::move(dir_entry), listing_bytes);
+    }
+    return true;
+}
+
+bool FileManager::list_directory_page(const std::string& path, std::string& cursor, size_t limit,
+                                      std::vector<FileInfo>& items) {
+    if (!check_path_security(path) || limit == 0) {
+        return false;
     }
     
+    int fd = open(get_absolute_path(path).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat dir_st;
+    DIR* dir = fstat(fd, &dir_st) == 0 ? fdopendir(fd) : nullptr;
+    if (!dir) {
+        close(fd);
+        return false;
+    }
+    
+    // 目录被替换或令牌被篡改时拒绝续读
+    std::string after;
+    if (!cursor.empty() && !decode_page_token(cursor, dir_st, after)) {
+        closedir(dir);
+        return false;
+    }
+    
+    // 页内按名称排序，从上一页最后一个名称之后续读：telldir 的位置在重新打开目录后不保证有效，
+    // 名称在两次请求之间新增或删除的条目也不会使其他条目重复或遗漏。
+    // 每页扫描整个目录，但只用大小为 limit + 1 的堆保留排在最前的名称，内存占用只与 limit 有关
+    std::priority_queue<std::string> smallest;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0 ||
+            is_temporary_name(entry->d_name) || (!cursor.empty() && after.compare(entry->d_name) >= 0)) {
+            continue;
+        }
+        if (smallest.size() <= limit) {
+            smallest.push(entry->d_name);
+        } else if (smallest.top().compare(entry->d_name) > 0) {
+            smallest.pop();
+            smallest.push(entry->d_name);
+        }
+    }
+    
+    // 多出的一项说明还有下一页
+    bool more = smallest.size() > limit;
+    if (more) {
+        smallest.pop();
+    }
+    std::vector<std::string> names;
+    names.reserve(smallest.size());
+    while (!smallest.empty()) {
+        names.push_back(smallest.top());
+        smallest.pop();
+    }
+    std::reverse(names.begin(), names.end());
+    
+    int dir_fd = dirfd(dir);
+    std::string prefix = path == "/" ? std::string() : path;
+    for (const std::string& name : names) {
+        // 扫描之后被删除的条目跳过
+        struct stat st;
+        if (fstatat(dir_fd, name.c_str(), &st, 0) != 0) {
+            continue;
+        }
+        FileInfo info;
+        fill_file_info(prefix + "/" + name, st, info);
+        items.push_back(std::move(info));
+    }
+    cursor = more ? encode_page_token(dir_st, names.back()) : std::string();
+    
     closedir(dir);
     return true;
 }
 
-bool FileManager::set_properties(const std::string& path, 
-                               const std::map<std::string, std::string>& properties) {
+bool FileManager::walk_directory(const std::string& path, int max_depth, const WalkVisitor& visitor,
+                                 const WalkErrorVisitor& on_error) {
+    return walk_tree(path, max_depth, [&visitor](const FileInfo& info, int depth) {
+        return is_temporary_name(info.name.c_str()) || visitor(info, depth);
+    }, on_error);
+}
+
+bool FileManager::walk_tree(const std::string& path, int max_depth, const WalkVisitor& visitor,
+                            const WalkErrorVisitor& on_error) {
     if (!check_path_security(path)) {
         return false;
     }
     
-    FileInfo info;
-    if (!get_resource_info(path, info)) {
+    int fd = open(get_absolute_path(path).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
         return false;
     }
     
-    info.properties = properties;
+    TreeWalker walker(fd, path == "/" ? std::string() : path, max_depth, traversal_permits_, traversal_threads_,
+                      [this](const std::string& sub_path, const struct stat& st, FileInfo& info) {
+                          fill_file_info(sub_path, st, info);
+                      });
+    walker.run(visitor, on_error);
     return true;
 }
 
-bool FileManager::get_properties(const std::string& path, 
-                               std::map<std::string, std::string>& properties) {
+void FileManager::collect_tree(const std::string& path, std::vector<TreeEntry>& entries) {
+    // 先序中每一层最近出现的目录就是其后同一层以下条目所在的目录
+    std::vector<size_t> last_directory;
+    size_t prefix = (path == "/" ? 0 : path.size()) + 1;
+    walk_tree(path, std::numeric_limits<int>::max(), [&](const FileInfo& info, int depth) {
+        size_t parent = depth > 1 ? last_directory[depth - 2] : NO_PARENT;
+        if (info.is_directory) {
+            last_directory.resize(depth);
+            last_directory[depth - 1] = entries.size();
+        }
+        entries.push_back(TreeEntry{info.path, info.path.substr(prefix), info.name, info.is_directory,
+                                    depth, parent});
+        return true;
+    });
+}
+
+void FileManager::for_each_parallel(const std::vector<TreeEntry>& entries, const std::vector<size_t>& indices,
+                                    int src_root, int dest_root,
+                                    const std::function<void(size_t index, int src_dir, int dest_dir)>& fn) {
+    std::vector<size_t> sorted(indices);
+    std::stable_sort(sorted.begin(), sorted.end(), [&entries](size_t a, size_t b) {
+        return entries[a].parent + 1 < entries[b].parent + 1;   // NO_PARENT 排在最前
+    });
+    
+    const std::string root;
+    tree_helpers_->parallel_for(sorted.size(), TREE_OPERATION_CHUNK, [&](size_t begin, size_t end) {
+        DirectoryHandle src(src_root);
+        DirectoryHandle dest(dest_root);
+        for (size_t i = begin; i < end; ++i) {
+            size_t parent = entries[sorted[i]].parent;
+            const std::string& relative = parent == NO_PARENT ? root : entries[parent].relative;
+            int dest_dir = dest.get(relative);
+            int dest_error = errno;
+            int src_dir = src.get(relative);
+            if (src_dir >= 0 && dest_dir < 0) {
+                errno = dest_error;
+            }
+            fn(sorted[i], src_dir, dest_dir);
+        }
+    });
+}
+
+bool FileManager::open_property_store(const std::string& log_path) {
+    if (!properties_->open(log_path)) {
+        return false;
+    }
+    // 载入前缓存的条目不含死属性
+    invalidate("", true);
+    return true;
+}
+
+void FileManager::set_durability(DurabilityMode mode, unsigned group_commit_us) {
+    durability_ = mode;
+    group_commit_.reset(mode == DurabilityMode::GROUP_COMMIT ? new GroupCommit(group_commit_us) : nullptr);
+    if (mode == DurabilityMode::GROUP_COMMIT) {
+        logger_.info("File writes synced by group commit every " + std::to_string(group_commit_us) + "us");
+    } else if (mode == DurabilityMode::NONE) {
+        logger_.warning("File writes are not synced, data may be lost on power failure");
+    }
+}
+
+bool FileManager::sync_parent_directory(const std::string& abs_path) {
+    if (durability_ == DurabilityMode::NONE) {
+        return true;
+    }
+    int dir_fd = open(parent_directory(abs_path).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) {
+        return false;
+    }
+    bool synced = sync_file(dir_fd);
+    int error = errno;
+    close(dir_fd);
+    errno = error;
+    return synced;
+}
+
+bool FileManager::sync_file(int fd) {
+    switch (durability_) {
+    case DurabilityMode::GROUP_COMMIT:
+        return group_commit_->sync(fd);
+    case DurabilityMode::NONE:
+        return true;
+    default:
+        return fsync(fd) == 0;
+    }
+}
+
+FileManager::CacheStats FileManager::get_cache_stats() {
+    CacheStats stats;
+    stats.info = cache_.get_stats();
+    stats.listing = dir_cache_.get_stats();
+    stats.missing = missing_.get_stats();
+    return stats;
+}
+
+bool FileManager::update_properties(const std::string& path, const std::map<std::string, std::string>& set,
+                                    const std::vector<std::string>& remove) {
     if (!check_path_security(path)) {
         return false;
     }
     
-    FileInfo info;
-    if (!get_resource_info(path, info)) {
+    if (!properties_->update(property_key(path), set, remove)) {
+        return false;
+    }
+    invalidate(get_absolute_path(path), false);
+    return true;
+}
+
+bool FileManager::get_properties(const std::string& path, 
+                               std::map<std::string, std::string>& properties) {
+    if (!check_path_security(path)) {
         return false;
     }
     
-    properties = info.properties;
+    properties.clear();
+    properties_->get(property_key(path), properties);
     return true;
 }
 
-bool FileManager::write_file_stream(const std::string& path, int* fd_out) {
+bool FileManager::write_file_stream(const std::string& path, FileWriter& writer, size_t expected_size) {
     if (!check_path_security(path)) {
         logger_.error("Security check failed for path: " + path);
         return false;
@@ -444,39 +1197,174 @@ bool FileManager::write_file_stream(const std::string& path, int* fd_out) {
         return false;
     }
     
-    // 打开文件
-    int fd = open(abs_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    // 临时文件与目标放在同一目录，保证最后的发布是原子的；
+    // 文件系统不支持 O_TMPFILE 时退回有名的临时文件
+    int fd = open(parent_path.c_str(), O_TMPFILE | O_WRONLY | O_CLOEXEC, 0644);
+    std::string temp_path;
     if (fd < 0) {
-        logger_.error("Failed to open file: " + std::string(strerror(errno)));
-        return false;
+        std::string temp_template = parent_path + "/" + TEMP_PREFIX + "XXXXXX";
+        std::vector<char> temp_name(temp_template.begin(), temp_template.end());
+        temp_name.push_back('\0');
+        
+        fd = mkostemp(temp_name.data(), O_CLOEXEC);
+        if (fd < 0) {
+            logger_.error("Failed to create temp file: " + std::string(strerror(errno)));
+            return false;
+        }
+        fchmod(fd, 0644);
+        temp_path = temp_name.data();
     }
     
-    if (fd_out) {
-        *fd_out = fd;
+    // 按声明的长度一次分配好空间，减少逐块增长造成的碎片；不改变文件大小，
+    // 实际写入不足时在 finish_write 中截掉多余的部分。声明的长度来自客户端，预分配量有上限，
+    // 且不超过剩余空间的一部分，避免一个慢速上传占住磁盘让其他写入失败
+    writer.preallocated = 0;
+    struct statvfs fs;
+    if (expected_size > 0 && fstatvfs(fd, &fs) == 0) {
+        size_t available = static_cast<size_t>(fs.f_bavail) * fs.f_frsize;
+        size_t reserve = std::min(expected_size, std::min(MAX_PREALLOCATION, available / PREALLOCATION_SHARE));
+        if (reserve > 0) {
+            // 失败时可能已经分配了一部分（ext4、XFS 不回滚），文件还是空的，截到 0 即可全部释放
+            if (fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(reserve)) == 0) {
+                writer.preallocated = reserve;
+            } else if (ftruncate(fd, 0) != 0) {
+                logger_.warning("Failed to release partial preallocation: " + std::string(strerror(errno)));
+            }
+        }
     }
     
+    writer.fd = fd;
+    writer.path = abs_path;
+    writer.temp_path = temp_path;
+    writer.offset = 0;
+    writer.async = use_uring_ && thread_uring_queue() != nullptr;
     return true;
 }
 
-bool FileManager::finish_write(const std::string& path, int fd) {
-    if (fd < 0) return false;
+bool FileManager::write_stream_data(FileWriter& writer, const char* data, size_t size) {
+    if (writer.async) {
+        // 提交后立即返回，磁盘写入与接收下一块数据并行
+        if (!thread_uring_queue()->write(writer.fd, data, size, writer.offset)) {
+            logger_.error("Failed to write data: " + std::string(strerror(thread_uring_queue()->error())));
+            return false;
+        }
+        writer.offset += size;
+        return true;
+    }
     
-    // 同步文件到磁盘
-    if (fsync(fd) < 0) {
-        logger_.error("Failed to sync file: " + std::string(strerror(errno)));
+    while (size > 0) {
+        ssize_t written = write(writer.fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            logger_.error("Failed to write data: " + std::string(strerror(errno)));
+            return false;
+        }
+        data += written;
+        size -= written;
+        writer.offset += written;
     }
+    return true;
+}
+
+bool FileManager::finish_write(FileWriter& writer) {
+    if (writer.fd < 0) return false;
     
-    close(fd);
+    // 释放预分配但没有用到的空间
+    if (writer.preallocated > writer.offset) {
+        if (writer.async) {
+            thread_uring_queue()->drain();
+        }
+        if (ftruncate(writer.fd, static_cast<off_t>(writer.offset)) != 0) {
+            logger_.warning("Failed to release preallocated space: " + std::string(strerror(errno)));
+        }
+    }
+    
+    // 同步文件到磁盘，异步写入时 fsync 排在所有在途写入之后；
+    // 不逐个 fsync 的策略下先等在途写入完成，再按策略同步
+    bool synced;
+    if (!writer.async) {
+        synced = sync_file(writer.fd);
+    } else if (durability_ == DurabilityMode::FSYNC) {
+        synced = thread_uring_queue()->fsync(writer.fd);
+    } else {
+        synced = thread_uring_queue()->drain() && sync_file(writer.fd);
+    }
+    if (!synced) {
+        int error = writer.async ? thread_uring_queue()->error() : errno;
+        logger_.error("Failed to sync file: " + std::string(strerror(error)));
+        abort_write(writer);
+        return false;
+    }
+    
+    if (!publish_file(writer)) {
+        logger_.error("Failed to publish file " + writer.path + ": " + std::string(strerror(errno)));
+        abort_write(writer);
+        return false;
+    }
+    close(writer.fd);
+    writer.fd = -1;
     
     // 清除缓存
-    std::string abs_path = get_absolute_path(path);
-    {
-        std::lock_guard<std::mutex> lock(cache_mutex_);
-        cache_.erase(abs_path);
+    invalidate(writer.path, false);
+    
+    // 文件已经发布，目录项同步失败时只能报告客户端持久化没有完成
+    if (!sync_parent_directory(writer.path)) {
+        logger_.error("Failed to sync directory of " + writer.path + ": " + std::string(strerror(errno)));
+        return false;
     }
     
-    logger_.info("Successfully finished writing file: " + abs_path);
+    logger_.info("Successfully finished writing file: " + writer.path);
     return true;
 }
 
+bool FileManager::publish_file(FileWriter& writer) {
+    // 有名临时文件直接 rename 覆盖目标
+    if (!writer.temp_path.empty()) {
+        if (rename(writer.temp_path.c_str(), writer.path.c_str()) != 0) {
+            return false;
+        }
+        writer.temp_path.clear();
+        return true;
+    }
+    
+    // 匿名文件：目标不存在时直接链接到目标名，一步完成
+    if (link_anonymous_file(writer.fd, writer.path)) {
+        return true;
+    }
+    if (errno != EEXIST) {
+        return false;
+    }
+    
+    // 目标已存在：链接到同目录下的临时名后 rename 原子替换，临时名只在这两步之间存在
+    static std::atomic<unsigned long> counter(0);
+    char suffix[64];
+    snprintf(suffix, sizeof(suffix), "/%s%d_%lu", TEMP_PREFIX, static_cast<int>(getpid()), ++counter);
+    std::string temp_path = parent_directory(writer.path) + suffix;
+    if (!link_anonymous_file(writer.fd, temp_path)) {
+        return false;
+    }
+    if (rename(temp_path.c_str(), writer.path.c_str()) != 0) {
+        int error = errno;
+        unlink(temp_path.c_str());
+        errno = error;
+        return false;
+    }
+    return true;
+}
+
+void FileManager::abort_write(FileWriter& writer) {
+    if (writer.async) {
+        // 在途写入仍引用该 fd，须先等它们结束
+        thread_uring_queue()->drain();
+        writer.async = false;
+    }
+    if (writer.fd >= 0) {
+        close(writer.fd);
+        writer.fd = -1;
+    }
+    if (!writer.temp_path.empty()) {
+        unlink(writer.temp_path.c_str());
+    }
+}
+
 } // namespace webdav 
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "file_watcher.h"
+#include "logger.h"
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+#include <vector>
+
+namespace webdav {
+
+namespace {
+
+// 内容变化只在关闭写入时通知：IN_MODIFY 在 PUT 的每个写入块都会触发，反复冲掉缓存；
+// 本进程的写入完成时自行失效，其他进程写入期间的大小变化在关闭后才可见
+const uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVED_FROM |
+                            IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR |
+                            IN_EXCL_UNLINK;
+const size_t EVENT_BUFFER_SIZE = 64 * 1024;
+
+// path 是 dir 本身或位于 dir 之下
+bool is_within(const std::string& path, const std::string& dir) {
+    return path.compare(0, dir.size(), dir) == 0 &&
+           (path.size() == dir.size() || path[dir.size()] == '/');
+}
+
+} // namespace
+
+FileWatcher::FileWatcher(Logger& logger, const Callback& callback)
+    : logger_(logger), callback_(callback), inotify_fd_(-1), wake_fd_(-1), limit_reported_(false) {}
+
+FileWatcher::~FileWatcher() {
+    stop();
+}
+
+bool FileWatcher::start() {
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) {
+        logger_.warning("inotify unavailable: " + std::string(strerror(errno)));
+        return false;
+    }
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ < 0) {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+        return false;
+    }
+
+    thread_ = std::thread(&FileWatcher::run, this);
+    return true;
+}
+
+void FileWatcher::stop() {
+    if (thread_.joinable()) {
+        uint64_t one = 1;
+        if (write(wake_fd_, &one, sizeof(one)) < 0) {
+            logger_.error("Failed to wake file watcher: " + std::string(strerror(errno)));
+        }
+        thread_.join();
+    }
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+        wake_fd_ = -1;
+    }
+    if (inotify_fd_ >= 0) {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+}
+
+bool FileWatcher::watch(const std::string& abs_dir) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (inotify_fd_ < 0) {
+        return false;
+    }
+    if (path_wds_.count(abs_dir)) {
+        return true;
+    }
+
+    int wd = inotify_add_watch(inotify_fd_, abs_dir.c_str(), WATCH_MASK);
+    if (wd < 0) {
+        if (errno == ENOSPC && !limit_reported_) {
+            limit_reported_ = true;
+            logger_.warning("inotify watch limit reached, falling back to TTL caching for new directories");
+        }
+        return false;
+    }
+
+    // 同一个目录换了路径（已被移动）时内核返回原来的 wd，旧路径作废
+    auto it = wd_paths_.find(wd);
+    if (it != wd_paths_.end()) {
+        path_wds_.erase(it->second);
+    }
+    wd_paths_[wd] = abs_dir;
+    path_wds_[abs_dir] = wd;
+    return true;
+}
+
+void FileWatcher::run() {
+    std::vector<char> buffer(EVENT_BUFFER_SIZE);
+    struct pollfd fds[2];
+    fds[0].fd = inotify_fd_;
+    fds[0].events = POLLIN;
+    fds[1].fd = wake_fd_;
+    fds[1].events = POLLIN;
+
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            logger_.error("File watcher poll failed: " + std::string(strerror(errno)));
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+
+        ssize_t length = read(inotify_fd_, buffer.data(), buffer.size());
+        if (length <= 0) {
+            continue;
+        }
+        for (char* p = buffer.data(); p < buffer.data() + length; ) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+            handle_event(event->wd, event->mask, event->len > 0 ? event->name : "");
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+
+void FileWatcher::handle_event(int wd, uint32_t mask, const char* name) {
+    if (mask & IN_Q_OVERFLOW) {
+        logger_.warning("inotify queue overflow, invalidating all cached metadata");
+        callback_("", true);
+        return;
+    }
+
+    std::string changed;
+    bool subtree = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = wd_paths_.find(wd);
+        if (it == wd_paths_.end()) {
+            return;
+        }
+        std::string dir = it->second;
+
+        if (mask & IN_IGNORED) {
+            // 监视已被内核移除（目录删除或卸载）
+            path_wds_.erase(dir);
+            wd_paths_.erase(it);
+            changed = dir;
+        } else if (mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+            forget_tree(dir);
+            changed = dir;
+        } else if (name[0] != '\0') {
+            changed = dir + "/" + name;
+            subtree = (mask & IN_ISDIR) != 0;
+            if ((mask & IN_ISDIR) && (mask & (IN_DELETE | IN_MOVED_FROM))) {
+                forget_tree(changed);
+            }
+        } else {
+            changed = dir;  // 目录自身的属性变化
+            subtree = false;
+        }
+    }
+
+    callback_(changed, subtree);
+}
+
+void FileWatcher::forget_tree(const std::string& dir) {
+    auto it = path_wds_.lower_bound(dir);
+    while (it != path_wds_.end() && it->first.compare(0, dir.size(), dir) == 0) {
+        if (!is_within(it->first, dir)) {
+            ++it;
+            continue;
+        }
+        inotify_rm_watch(inotify_fd_, it->second);
+        wd_paths_.erase(it->second);
+        it = path_wds_.erase(it);
+    }
+}
+
+} // namespace webdav
@@ -0,0 +1,88 @@
+#include "group_commit.h"
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <chrono>
+#include <thread>
+
+namespace webdav {
+
+namespace {
+
+// syncfs 从 Linux 5.8 起才返回文件系统上的回写错误
+bool syncfs_reports_errors() {
+    struct utsname name;
+    int major = 0;
+    int minor = 0;
+    if (uname(&name) != 0 || sscanf(name.release, "%d.%d", &major, &minor) != 2) {
+        return false;
+    }
+    return major > 5 || (major == 5 && minor >= 8);
+}
+
+} // namespace
+
+GroupCommit::GroupCommit(unsigned window_us)
+    : window_us_(window_us), use_syncfs_(syncfs_reports_errors()), syncing_(false) {}
+
+bool GroupCommit::sync(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    bool leader = !current_;
+    if (leader) {
+        current_ = std::make_shared<Batch>();
+    }
+    std::shared_ptr<Batch> batch = current_;
+    batch->fds.push_back(fd);
+    batch->devices.push_back(st.st_dev);
+
+    if (leader) {
+        // 上一批同步期间以及窗口内到达的写入都加入本批，然后关闭本批，新到的写入进入下一批
+        cv_.wait(lock, [this] { return !syncing_; });
+        if (window_us_ > 0) {
+            lock.unlock();
+            std::this_thread::sleep_for(std::chrono::microseconds(window_us_));
+            lock.lock();
+        }
+        current_.reset();
+        syncing_ = true;
+        lock.unlock();
+
+        // 批次关闭后不再有人修改，不持锁读取
+        int error = 0;
+        for (size_t i = 0; i < batch->fds.size(); ++i) {
+            if (use_syncfs_) {
+                // 每个文件系统只同步一次
+                auto first = std::find(batch->devices.begin(), batch->devices.end(), batch->devices[i]);
+                if (static_cast<size_t>(first - batch->devices.begin()) != i) {
+                    continue;
+                }
+                if (syncfs(batch->fds[i]) != 0) {
+                    error = errno;
+                }
+            } else if (fsync(batch->fds[i]) != 0) {
+                error = errno;
+            }
+        }
+
+        lock.lock();
+        syncing_ = false;
+        batch->error = error;
+        batch->done = true;
+        cv_.notify_all();
+    } else {
+        cv_.wait(lock, [&batch] { return batch->done; });
+    }
+
+    errno = batch->error;
+    return batch->error == 0;
+}
+
+} // namespace webdav
@@ -0,0 +1,519 @@
+#include "property_store.h"
+#include "logger.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+#include <cstdint>
+
+namespace webdav {
+
+namespace {
+
+const char LOG_MAGIC[8] = {'W', 'D', 'P', 'R', 'O', 'P', 'S', '1'};
+const size_t RECORD_HEADER_SIZE = 8;              // 4 字节负载长度 + 4 字节 CRC32
+const size_t MAX_RECORD_SIZE = 64 * 1024 * 1024;  // 超出视为损坏
+const size_t COMPACT_MIN_SIZE = 1024 * 1024;      // 日志小于该大小时不压缩
+const size_t COMPACT_RATIO = 2;                   // 日志超过只保留当前索引时大小的这一倍数时压缩
+
+enum RecordType : unsigned char {
+    RECORD_UPDATE = 1,       // 路径, 设置的属性, 删除的属性名
+    RECORD_REMOVE_TREE = 2,  // 路径
+    RECORD_COPY = 3,         // 源路径, 目标路径
+    RECORD_MOVE_TREE = 4     // 源路径, 目标路径
+};
+
+uint32_t crc32(const char* data, size_t size) {
+    static uint32_t table[256];
+    static bool initialized = [] {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        return true;
+    }();
+    (void)initialized;
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// 记录中的整数按本机字节序存放，日志不在不同架构的机器之间共享
+void put_u32(std::string& out, uint32_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void put_string(std::string& out, const std::string& value) {
+    put_u32(out, static_cast<uint32_t>(value.size()));
+    out += value;
+}
+
+// 给负载加上长度和 CRC 组成完整记录
+std::string frame(const std::string& payload) {
+    std::string record;
+    record.reserve(RECORD_HEADER_SIZE + payload.size());
+    put_u32(record, static_cast<uint32_t>(payload.size()));
+    put_u32(record, crc32(payload.data(), payload.size()));
+    record += payload;
+    return record;
+}
+
+std::string update_payload(const std::string& path, const PropertyStore::PropertyMap& set,
+                           const std::vector<std::string>& remove) {
+    std::string payload(1, static_cast<char>(RECORD_UPDATE));
+    put_string(payload, path);
+    put_u32(payload, static_cast<uint32_t>(set.size()));
+    for (const auto& prop : set) {
+        put_string(payload, prop.first);
+        put_string(payload, prop.second);
+    }
+    put_u32(payload, static_cast<uint32_t>(remove.size()));
+    for (const auto& name : remove) {
+        put_string(payload, name);
+    }
+    return payload;
+}
+
+// 只保留该条目时在日志中占用的大小
+size_t entry_size(const std::string& path, const PropertyStore::PropertyMap& properties) {
+    size_t size = RECORD_HEADER_SIZE + 1 + 4 + path.size() + 4 + 4;
+    for (const auto& prop : properties) {
+        size += 8 + prop.first.size() + prop.second.size();
+    }
+    return size;
+}
+
+bool is_within(const std::string& path, const std::string& dir) {
+    return path.compare(0, dir.size(), dir) == 0 &&
+           (path.size() == dir.size() || path[dir.size()] == '/' || dir == "/");
+}
+
+class RecordReader {
+public:
+    RecordReader(const char* data, size_t size) : data_(data), end_(data + size) {}
+
+    bool read_u32(uint32_t& value) {
+        if (static_cast<size_t>(end_ - data_) < sizeof(value)) return false;
+        memcpy(&value, data_, sizeof(value));
+        data_ += sizeof(value);
+        return true;
+    }
+
+    bool read_string(std::string& value) {
+        uint32_t length;
+        if (!read_u32(length) || static_cast<size_t>(end_ - data_) < length) return false;
+        value.assign(data_, length);
+        data_ += length;
+        return true;
+    }
+
+    bool done() const { return data_ == end_; }
+
+private:
+    const char* data_;
+    const char* end_;
+};
+
+bool write_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+} // namespace
+
+PropertyStore::PropertyStore(Logger& logger)
+    : logger_(logger), fd_(-1), log_size_(0), live_size_(0), compacting_(false) {}
+
+PropertyStore::~PropertyStore() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool PropertyStore::open(const std::string& log_path) {
+    if (!load(log_path)) {
+        return false;
+    }
+    maybe_compact();
+    return true;
+}
+
+bool PropertyStore::load(const std::string& log_path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    log_path_ = log_path;
+    fd_ = ::open(log_path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        logger_.error("Failed to open property store " + log_path + ": " + strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        logger_.error("Failed to stat property store " + log_path + ": " + strerror(errno));
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    std::string data(static_cast<size_t>(st.st_size), '\0');
+    size_t loaded = 0;
+    while (loaded < data.size()) {
+        ssize_t n = pread(fd_, &data[loaded], data.size() - loaded, loaded);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        loaded += n;
+    }
+    data.resize(loaded);
+
+    if (data.empty()) {
+        if (!write_all(fd_, LOG_MAGIC, sizeof(LOG_MAGIC)) || fdatasync(fd_) != 0) {
+            logger_.error("Failed to initialize property store " + log_path + ": " + strerror(errno));
+            close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        log_size_ = sizeof(LOG_MAGIC);
+        return true;
+    }
+    if (data.size() < sizeof(LOG_MAGIC) || memcmp(data.data(), LOG_MAGIC, sizeof(LOG_MAGIC)) != 0) {
+        logger_.error("Not a property store: " + log_path);
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    // 重放日志，遇到第一条不完整或校验失败的记录就停止
+    size_t pos = sizeof(LOG_MAGIC);
+    size_t records = 0;
+    while (data.size() - pos >= RECORD_HEADER_SIZE) {
+        uint32_t length, crc;
+        memcpy(&length, data.data() + pos, 4);
+        memcpy(&crc, data.data() + pos + 4, 4);
+        if (length > MAX_RECORD_SIZE || data.size() - pos - RECORD_HEADER_SIZE < length) break;
+        const char* payload = data.data() + pos + RECORD_HEADER_SIZE;
+        if (crc32(payload, length) != crc || !replay(payload, length)) break;
+        pos += RECORD_HEADER_SIZE + length;
+        ++records;
+    }
+    if (pos < data.size()) {
+        logger_.warning("Property store " + log_path + " has " + std::to_string(data.size() - pos) +
+                        " trailing bytes of incomplete records, truncating");
+        if (ftruncate(fd_, pos) != 0) {
+            logger_.error("Failed to truncate property store: " + std::string(strerror(errno)));
+        }
+    }
+    log_size_ = pos;
+    logger_.info("Loaded " + std::to_string(entries_.size()) + " property entries from " +
+                 std::to_string(records) + " records in " + log_path);
+    return true;
+}
+
+bool PropertyStore::get(const std::string& path, PropertyMap& properties) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(path);
+    if (it == entries_.end()) {
+        return false;
+    }
+    properties = it->second;
+    return true;
+}
+
+bool PropertyStore::update(const std::string& path, const PropertyMap& set,
+                           const std::vector<std::string>& remove) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!append(frame(update_payload(path, set, remove)))) {
+            return false;
+        }
+        apply_update(path, set, remove);
+    }
+    maybe_compact();
+    return true;
+}
+
+bool PropertyStore::remove_tree(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 没有受影响的条目时不写日志，删除普通文件树不产生额外的磁盘写入
+        if (!has_tree(path)) {
+            return true;
+        }
+
+        std::string payload(1, static_cast<char>(RECORD_REMOVE_TREE));
+        put_string(payload, path);
+        if (!append(frame(payload))) {
+            return false;
+        }
+        erase_tree(path);
+    }
+    maybe_compact();
+    return true;
+}
+
+bool PropertyStore::copy(const std::string& src, const std::string& dest) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!entries_.count(src) && !entries_.count(dest)) {
+            return true;
+        }
+
+        std::string payload(1, static_cast<char>(RECORD_COPY));
+        put_string(payload, src);
+        put_string(payload, dest);
+        if (!append(frame(payload))) {
+            return false;
+        }
+        apply_copy(src, dest);
+    }
+    maybe_compact();
+    return true;
+}
+
+bool PropertyStore::move_tree(const std::string& src, const std::string& dest) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!has_tree(src) && !has_tree(dest)) {
+            return true;
+        }
+
+        std::string payload(1, static_cast<char>(RECORD_MOVE_TREE));
+        put_string(payload, src);
+        put_string(payload, dest);
+        if (!append(frame(payload))) {
+            return false;
+        }
+        apply_move_tree(src, dest);
+    }
+    maybe_compact();
+    return true;
+}
+
+bool PropertyStore::append(const std::string& record) {
+    if (fd_ < 0) {
+        return false;
+    }
+
+    // 一条记录一次写入；写入失败时截掉可能已写入的部分，保持日志可重放
+    if (!write_all(fd_, record.data(), record.size()) || fdatasync(fd_) != 0) {
+        logger_.error("Failed to append to property store: " + std::string(strerror(errno)));
+        if (ftruncate(fd_, log_size_) != 0) {
+            logger_.error("Failed to roll back property store: " + std::string(strerror(errno)));
+        }
+        return false;
+    }
+    log_size_ += record.size();
+    return true;
+}
+
+bool PropertyStore::replay(const char* data, size_t size) {
+    if (size == 0) {
+        return false;
+    }
+    RecordReader reader(data + 1, size - 1);
+    std::string path, dest;
+
+    switch (static_cast<unsigned char>(data[0])) {
+    case RECORD_UPDATE: {
+        uint32_t count;
+        PropertyMap set;
+        std::vector<std::string> remove;
+        if (!reader.read_string(path) || !reader.read_u32(count)) return false;
+        for (uint32_t i = 0; i < count; ++i) {
+            std::string name, value;
+            if (!reader.read_string(name) || !reader.read_string(value)) return false;
+            set[name] = value;
+        }
+        if (!reader.read_u32(count)) return false;
+        for (uint32_t i = 0; i < count; ++i) {
+            std::string name;
+            if (!reader.read_string(name)) return false;
+            remove.push_back(name);
+        }
+        if (!reader.done()) return false;
+        apply_update(path, set, remove);
+        return true;
+    }
+    case RECORD_REMOVE_TREE:
+        if (!reader.read_string(path) || !reader.done()) return false;
+        erase_tree(path);
+        return true;
+    case RECORD_COPY:
+        if (!reader.read_string(path) || !reader.read_string(dest) || !reader.done()) return false;
+        apply_copy(path, dest);
+        return true;
+    case RECORD_MOVE_TREE:
+        if (!reader.read_string(path) || !reader.read_string(dest) || !reader.done()) return false;
+        apply_move_tree(path, dest);
+        return true;
+    default:
+        return false;
+    }
+}
+
+void PropertyStore::maybe_compact() {
+    // 在锁内把当前索引序列化为新日志的内容，写入和同步在锁外进行，期间查询和修改照常
+    std::string data;
+    size_t snapshot_end;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (fd_ < 0 || compacting_ || log_size_ <= COMPACT_MIN_SIZE || log_size_ <= COMPACT_RATIO * live_size_) {
+            return;
+        }
+        compacting_ = true;
+        data.reserve(live_size_ + sizeof(LOG_MAGIC));
+        data.assign(LOG_MAGIC, sizeof(LOG_MAGIC));
+        const std::vector<std::string> no_removals;
+        for (const auto& entry : entries_) {
+            data += frame(update_payload(entry.first, entry.second, no_removals));
+        }
+        snapshot_end = log_size_;
+    }
+
+    std::string temp_path = log_path_ + ".tmp";
+    int fd = ::open(temp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        logger_.error("Failed to create " + temp_path + ": " + strerror(errno));
+    } else if (!write_all(fd, data.data(), data.size()) || fsync(fd) != 0) {
+        logger_.error("Failed to write " + temp_path + ": " + strerror(errno));
+        close(fd);
+        unlink(temp_path.c_str());
+        fd = -1;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    compacting_ = false;
+    if (fd >= 0 && !compact(fd, temp_path, data.size(), snapshot_end)) {
+        close(fd);
+        unlink(temp_path.c_str());
+    }
+}
+
+bool PropertyStore::compact(int fd, const std::string& temp_path, size_t compacted_size, size_t snapshot_end) {
+    // 快照之后追加到旧日志的记录原样接到新日志末尾，再原子替换
+    std::string tail(log_size_ - snapshot_end, '\0');
+    size_t loaded = 0;
+    while (loaded < tail.size()) {
+        ssize_t n = pread(fd_, &tail[loaded], tail.size() - loaded, snapshot_end + loaded);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        loaded += n;
+    }
+    if (loaded < tail.size()) {
+        logger_.error("Failed to read property store tail: " + std::string(strerror(errno)));
+        return false;
+    }
+    if (!tail.empty() && (!write_all(fd, tail.data(), tail.size()) || fdatasync(fd) != 0)) {
+        logger_.error("Failed to write " + temp_path + ": " + strerror(errno));
+        return false;
+    }
+    if (rename(temp_path.c_str(), log_path_.c_str()) != 0) {
+        logger_.error("Failed to replace property store: " + std::string(strerror(errno)));
+        return false;
+    }
+
+    // 临时文件本身以追加方式打开，替换后直接作为日志的句柄
+    close(fd_);
+    fd_ = fd;
+    logger_.info("Compacted property store from " + std::to_string(log_size_) + " to " +
+                 std::to_string(compacted_size + tail.size()) + " bytes");
+    log_size_ = compacted_size + tail.size();
+    return true;
+}
+
+void PropertyStore::set_entry(const std::string& path, const PropertyMap& properties) {
+    auto it = entries_.find(path);
+    if (it != entries_.end()) {
+        live_size_ -= entry_size(it->first, it->second);
+        if (properties.empty()) {
+            entries_.erase(it);
+            return;
+        }
+        it->second = properties;
+    } else if (properties.empty()) {
+        return;
+    } else {
+        entries_[path] = properties;
+    }
+    live_size_ += entry_size(path, properties);
+}
+
+bool PropertyStore::has_tree(const std::string& path) const {
+    if (path == "/") {
+        return !entries_.empty();
+    }
+    // "/docs b"、"/docs-x" 等兄弟路径排在 "/docs" 和 "/docs/" 之间，子路径须从 "/docs/" 起查找
+    if (entries_.count(path)) {
+        return true;
+    }
+    auto it = entries_.lower_bound(path + "/");
+    return it != entries_.end() && is_within(it->first, path);
+}
+
+void PropertyStore::erase_tree(const std::string& path) {
+    auto it = entries_.lower_bound(path);
+    while (it != entries_.end() && it->first.compare(0, path.size(), path) == 0) {
+        if (is_within(it->first, path)) {
+            live_size_ -= entry_size(it->first, it->second);
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void PropertyStore::apply_update(const std::string& path, const PropertyMap& set,
+                                 const std::vector<std::string>& remove) {
+    PropertyMap properties;
+    auto it = entries_.find(path);
+    if (it != entries_.end()) {
+        properties = it->second;
+    }
+    for (const auto& name : remove) {
+        properties.erase(name);
+    }
+    for (const auto& prop : set) {
+        properties[prop.first] = prop.second;
+    }
+    set_entry(path, properties);
+}
+
+void PropertyStore::apply_copy(const std::string& src, const std::string& dest) {
+    auto it = entries_.find(src);
+    set_entry(dest, it != entries_.end() ? PropertyMap(it->second) : PropertyMap());
+}
+
+void PropertyStore::apply_move_tree(const std::string& src, const std::string& dest) {
+    std::vector<std::pair<std::string, PropertyMap>> moved;
+    auto it = entries_.lower_bound(src);
+    while (it != entries_.end() && it->first.compare(0, src.size(), src) == 0) {
+        if (is_within(it->first, src)) {
+            moved.push_back(std::make_pair(dest + it->first.substr(src.size()), it->second));
+            live_size_ -= entry_size(it->first, it->second);
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    erase_tree(dest);
+    for (const auto& entry : moved) {
+        set_entry(entry.first, entry.second);
+    }
+}
+
+} // namespace webdav
@@ -0,0 +1,464 @@
+#include "tree_walker.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+namespace webdav {
+
+namespace {
+
+const size_t STAT_CHUNK = 128;         // 每个 stat 任务处理的条目数
+const size_t MAX_BUFFERED = 16384;     // 已读取但尚未交给回调的条目上限
+
+enum EntryStatus : unsigned char {
+    ENTRY_SKIPPED = 0,   // stat 失败或悬空链接
+    ENTRY_LEAF = 1,
+    ENTRY_DIRECTORY = 2  // 真实目录（不是指向目录的符号链接），可以进入
+};
+
+} // namespace
+
+// 目录句柄，最后一个引用释放时关闭；子目录在打开之前一直持有父目录的句柄
+class TreeWalker::Fd {
+public:
+    explicit Fd(int fd) : fd(fd) {}
+    ~Fd() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    const int fd;
+};
+
+struct TreeWalker::Node {
+    enum State { PENDING, SCANNING, READY };
+
+    std::string path;     // 相对路径，条目的路径为 path + "/" + 名称
+    std::string name;
+    int depth;            // 起点为 0
+    std::shared_ptr<Fd> parent;
+    std::shared_ptr<Fd> fd;
+    State state;
+    size_t chunks_left;
+    int error;            // 打开或读取目录失败时的 errno，此时没有条目
+
+    std::vector<std::string> names;       // 按名称排序
+    std::vector<unsigned char> types;     // readdir 给出的 d_type
+    std::vector<unsigned char> status;    // EntryStatus
+    std::vector<FileInfo> infos;
+    std::vector<std::shared_ptr<Node>> children;
+
+    Node() : depth(0), state(PENDING), chunks_left(0), error(0) {}
+};
+
+TreeWalker::TreeWalker(int root_fd, const std::string& root_path, int max_depth,
+                       std::atomic<int>& permits, size_t max_helpers, const InfoBuilder& build)
+    : max_depth_(max_depth), permits_(permits), max_helpers_(max_helpers),
+      build_(build), root_(new Node()), buffered_(0), idle_helpers_(0), queued_(0), stop_(false) {
+    for (size_t i = 0; i <= max_helpers_; ++i) {
+        slots_.emplace_back(new Slot());
+    }
+    root_->path = root_path;
+    root_->fd = std::make_shared<Fd>(root_fd);
+}
+
+TreeWalker::~TreeWalker() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        deferred_.clear();
+    }
+    cv_.notify_all();
+    for (auto& helper : helpers_) {
+        helper.join();
+    }
+}
+
+void TreeWalker::run(const WalkVisitor& visitor, const WalkErrorVisitor& on_error) {
+    if (max_depth_ < 1) {
+        return;
+    }
+    wait_ready(root_);
+
+    struct Frame {
+        std::shared_ptr<Node> node;
+        size_t next;
+    };
+    std::vector<Frame> stack;
+    stack.push_back(Frame{root_, 0});
+
+    while (!stack.empty()) {
+        std::shared_ptr<Node> node = stack.back().node;
+        size_t index = stack.back().next;
+        if (index == node->infos.size()) {
+            // 目录的条目都已交出：释放节点并归还预算
+            stack.pop_back();
+            if (!stack.empty()) {
+                stack.back().node->children[stack.back().next - 1].reset();
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            buffered_ -= node->infos.size();
+            schedule_deferred(0);
+            continue;
+        }
+
+        stack.back().next++;
+        if (node->status[index] == ENTRY_SKIPPED) {
+            continue;
+        }
+
+        // 子目录先读完再交出，无法读取时改为报告错误
+        std::shared_ptr<Node> child = node->children[index];
+        if (child) {
+            wait_ready(child);
+            if (child->error != 0 && on_error) {
+                node->children[index].reset();
+                if (!on_error(node->infos[index], node->depth + 1, child->error)) {
+                    break;
+                }
+                continue;
+            }
+        }
+        if (!visitor(node->infos[index], node->depth + 1)) {
+            break;
+        }
+        if (child) {
+            stack.push_back(Frame{child, 0});
+        }
+    }
+}
+
+void TreeWalker::worker(size_t slot) {
+    while (true) {
+        Task task;
+        if (take(slot, task)) {
+            execute(slot, task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++idle_helpers_;
+        cv_.wait(lock, [this] { return stop_ || queued_.load() > 0; });
+        --idle_helpers_;
+        if (stop_) {
+            break;
+        }
+    }
+    permits_.fetch_add(1);
+}
+
+bool TreeWalker::take(size_t slot, Task& task) {
+    {
+        Slot& own = *slots_[slot];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            queued_.fetch_sub(1);
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < slots_.size(); ++i) {
+        Slot& victim = *slots_[(slot + i) % slots_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            queued_.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TreeWalker::push(size_t slot, const Task& task) {
+    Slot& own = *slots_[slot];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    own.tasks.push_back(task);
+    queued_.fetch_add(1);
+}
+
+void TreeWalker::execute(size_t slot, const Task& task) {
+    if (task.begin == task.end) {
+        {
+            // 目录可能已被等待它的调用线程直接读取，或遍历已经结束
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stop_ || task.node->state != Node::PENDING) {
+                return;
+            }
+            task.node->state = Node::SCANNING;
+        }
+        scan(slot, task.node);
+    } else {
+        stat_range(slot, task.node, task.begin, task.end);
+    }
+}
+
+void TreeWalker::scan(size_t slot, const std::shared_ptr<Node>& node) {
+    if (!node->fd) {
+        int fd = openat(node->parent->fd, node->name.c_str(),
+                        O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd < 0) {
+            node->error = errno;
+        }
+        node->fd = std::make_shared<Fd>(fd);
+        node->parent.reset();
+    }
+
+    // 先读出全部名称并排序，结果顺序与文件系统返回的顺序无关
+    std::vector<std::pair<std::string, unsigned char>> entries;
+    int dup_fd = node->fd->fd >= 0 ? fcntl(node->fd->fd, F_DUPFD_CLOEXEC, 0) : -1;
+    DIR* dir = dup_fd >= 0 ? fdopendir(dup_fd) : nullptr;
+    if (dir) {
+        struct dirent* entry;
+        errno = 0;
+        while ((entry = readdir(dir)) != nullptr) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+                continue;
+            }
+            entries.push_back(std::make_pair(std::string(entry->d_name), entry->d_type));
+        }
+        node->error = errno;
+        closedir(dir);
+    } else if (node->error == 0) {
+        node->error = errno;
+        if (dup_fd >= 0) {
+            close(dup_fd);
+        }
+    }
+    // 读到一半出错的目录也不交出已读到的部分
+    if (node->error != 0) {
+        entries.clear();
+    }
+    std::sort(entries.begin(), entries.end());
+
+    size_t count = entries.size();
+    node->names.reserve(count);
+    node->types.reserve(count);
+    for (auto& entry : entries) {
+        node->names.push_back(std::move(entry.first));
+        node->types.push_back(entry.second);
+    }
+    node->status.assign(count, ENTRY_SKIPPED);
+    node->infos.resize(count);
+
+    if (count == 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finish(slot, node);
+        return;
+    }
+
+    // 大目录拆成多个 stat 任务供其他线程窃取，第一块由本线程直接处理
+    size_t chunks = (count + STAT_CHUNK - 1) / STAT_CHUNK;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        node->chunks_left = chunks;
+        buffered_ += count;
+    }
+    if (chunks > 1) {
+        for (size_t i = chunks - 1; i >= 1; --i) {
+            push(slot, Task{node, i * STAT_CHUNK, std::min(count, (i + 1) * STAT_CHUNK)});
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        maybe_spawn_helper();
+    }
+    stat_range(slot, node, 0, std::min(count, STAT_CHUNK));
+}
+
+void TreeWalker::stat_range(size_t slot, const std::shared_ptr<Node>& node, size_t begin, size_t end) {
+    int dir_fd = node->fd->fd;
+    for (size_t i = begin; i < end; ++i) {
+        const char* name = node->names[i].c_str();
+        unsigned char type = node->types[i];
+
+        // d_type 已知且不是符号链接时只需一次 fstatat
+        struct stat st;
+        bool is_directory;
+        if (type != DT_UNKNOWN && type != DT_LNK) {
+            if (fstatat(dir_fd, name, &st, 0) != 0) {
+                continue;
+            }
+            is_directory = S_ISDIR(st.st_mode);
+        } else {
+            if (fstatat(dir_fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+                continue;
+            }
+            is_directory = S_ISDIR(st.st_mode);
+            if (S_ISLNK(st.st_mode) && fstatat(dir_fd, name, &st, 0) != 0) {
+                continue;  // 悬空链接
+            }
+        }
+
+        build_(node->path + "/" + node->names[i], st, node->infos[i]);
+        node->status[i] = is_directory ? ENTRY_DIRECTORY : ENTRY_LEAF;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--node->chunks_left == 0) {
+        finish(slot, node);
+    }
+}
+
+void TreeWalker::finish(size_t slot, const std::shared_ptr<Node>& node) {
+    node->children.resize(node->infos.size());
+    if (node->depth + 1 < max_depth_ && !stop_) {
+        for (size_t i = 0; i < node->infos.size(); ++i) {
+            if (node->status[i] != ENTRY_DIRECTORY) {
+                continue;
+            }
+            std::shared_ptr<Node> child(new Node());
+            child->path = node->infos[i].path;
+            child->name = node->names[i];
+            child->depth = node->depth + 1;
+            child->parent = node->fd;
+            node->children[i] = child;
+            deferred_.push_back(child);
+        }
+    }
+
+    // 子目录持有需要的句柄，名称已复制到 FileInfo 中
+    node->fd.reset();
+    std::vector<std::string>().swap(node->names);
+    std::vector<unsigned char>().swap(node->types);
+    node->state = Node::READY;
+    schedule_deferred(slot);
+    cv_.notify_all();
+}
+
+void TreeWalker::schedule_deferred(size_t slot) {
+    bool pushed = false;
+    while (!stop_ && buffered_ < MAX_BUFFERED && !deferred_.empty()) {
+        std::shared_ptr<Node> node = deferred_.front();
+        deferred_.pop_front();
+        if (node->state == Node::PENDING) {
+            push(slot, Task{node, 0, 0});
+            pushed = true;
+        }
+    }
+    if (pushed) {
+        maybe_spawn_helper();
+    }
+}
+
+void TreeWalker::wait_ready(const std::shared_ptr<Node>& node) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (node->state == Node::PENDING) {
+        // 还没有线程开始读取（可能因预算暂缓），直接在调用线程读取
+        node->state = Node::SCANNING;
+        lock.unlock();
+        scan(0, node);
+        lock.lock();
+    }
+
+    while (node->state != Node::READY) {
+        lock.unlock();
+        Task task;
+        if (take(0, task)) {
+            execute(0, task);
+            lock.lock();
+            continue;
+        }
+        lock.lock();
+        cv_.wait(lock, [this, &node] { return node->state == Node::READY || queued_.load() > 0; });
+    }
+}
+
+void TreeWalker::maybe_spawn_helper() {
+    if (!stop_ && idle_helpers_ == 0 && helpers_.size() < max_helpers_ && queued_.load() > 0) {
+        int available = permits_.load();
+        while (available > 0 && !permits_.compare_exchange_weak(available, available - 1)) {
+        }
+        if (available > 0) {
+            helpers_.emplace_back(&TreeWalker::worker, this, helpers_.size() + 1);
+        }
+    }
+    cv_.notify_all();
+}
+
+HelperPool::HelperPool(size_t threads) : stop_(false) {
+    for (size_t i = 0; i < threads; ++i) {
+        threads_.emplace_back(&HelperPool::worker, this);
+    }
+}
+
+HelperPool::~HelperPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void HelperPool::parallel_for(size_t count, size_t chunk,
+                              const std::function<void(size_t begin, size_t end)>& fn) {
+    // 只有一块或没有辅助线程时直接在调用线程执行
+    if (threads_.empty() || count <= chunk) {
+        for (size_t begin = 0; begin < count; begin += chunk) {
+            fn(begin, std::min(count, begin + chunk));
+        }
+        return;
+    }
+
+    Job job;
+    job.count = count;
+    job.chunk = chunk;
+    job.fn = &fn;
+    job.next = 0;
+    job.active = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(&job);
+    }
+    work_cv_.notify_all();
+
+    drain(job);
+
+    // 块都已认领，等仍在执行本作业的辅助线程做完
+    std::unique_lock<std::mutex> lock(mutex_);
+    remove(&job);
+    done_cv_.wait(lock, [&job] { return job.active == 0; });
+}
+
+void HelperPool::worker() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        work_cv_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+        if (stop_) {
+            break;
+        }
+
+        Job* job = jobs_.front();
+        ++job->active;
+        lock.unlock();
+        drain(*job);
+        lock.lock();
+        // 作业的块已取完，不再交给其他线程；作业本身在 active 归零前不会被调用线程释放
+        remove(job);
+        --job->active;
+        done_cv_.notify_all();
+    }
+}
+
+void HelperPool::drain(Job& job) {
+    size_t begin;
+    while ((begin = job.next.fetch_add(job.chunk)) < job.count) {
+        (*job.fn)(begin, std::min(job.count, begin + job.chunk));
+    }
+}
+
+void HelperPool::remove(Job* job) {
+    auto it = std::find(jobs_.begin(), jobs_.end(), job);
+    if (it != jobs_.end()) {
+        jobs_.erase(it);
+    }
+}
+
+} // namespace webdav
@@ -0,0 +1,369 @@
+#include "uring_queue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <errno.h>
+#include <unistd.h>
+#include <vector>
+
+#ifdef WEBDAV_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+namespace webdav {
+
+const size_t UringQueue::BUFFER_SIZE;
+const unsigned UringQueue::BUFFER_COUNT;
+
+#ifdef WEBDAV_HAVE_IO_URING
+
+namespace {
+
+const unsigned RING_ENTRIES = 8;
+const unsigned PROBE_OPS = 256;   // 探测结果数组的长度，覆盖全部 8 位操作码
+const uint64_t FSYNC_TAG = UINT64_MAX;
+
+int io_uring_setup(unsigned entries, struct io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete,
+                                    flags, nullptr, 0));
+}
+
+int io_uring_register(int ring_fd, unsigned opcode, const void* arg, unsigned nr_args) {
+    return static_cast<int>(syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+}
+
+unsigned* ring_field(void* ring, uint32_t offset) {
+    return reinterpret_cast<unsigned*>(static_cast<char*>(ring) + offset);
+}
+
+} // namespace
+
+UringQueue::UringQueue()
+    : ring_fd_(-1), sq_ring_(MAP_FAILED), sq_ring_size_(0), cq_ring_(MAP_FAILED), cq_ring_size_(0),
+      sqes_(MAP_FAILED), sqes_size_(0), sq_head_(nullptr), sq_tail_(nullptr), sq_mask_(nullptr),
+      sq_array_(nullptr), cq_head_(nullptr), cq_tail_(nullptr), cq_mask_(nullptr), cqes_(nullptr),
+      buffers_(nullptr), registered_(false), inflight_(0), next_slot_(0), error_(0), last_error_(0),
+      fsync_done_(false), fsync_result_(0) {
+    memset(slots_, 0, sizeof(slots_));
+}
+
+UringQueue::~UringQueue() {
+    if (ring_fd_ >= 0) {
+        drain();
+    }
+    if (sqes_ != MAP_FAILED) {
+        munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != MAP_FAILED) {
+        munmap(sq_ring_, sq_ring_size_);
+    }
+    if (ring_fd_ >= 0) {
+        close(ring_fd_);
+    }
+    free(buffers_);
+}
+
+UringQueue* UringQueue::create(std::string& reason) {
+    UringQueue* queue = new UringQueue();
+    if (!queue->setup(reason)) {
+        delete queue;
+        return nullptr;
+    }
+    return queue;
+}
+
+bool UringQueue::setup(std::string& reason) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = io_uring_setup(RING_ENTRIES, &params);
+    if (ring_fd_ < 0) {
+        reason = "io_uring_setup failed: " + std::string(strerror(errno));
+        return false;
+    }
+
+    // 映射提交队列、完成队列和 SQE 数组；支持 SINGLE_MMAP 的内核上两个队列共用一次映射
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        reason = "Failed to map submission queue: " + std::string(strerror(errno));
+        return false;
+    }
+    cq_ring_ = single_mmap ? sq_ring_
+                           : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                                  MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+        reason = "Failed to map completion queue: " + std::string(strerror(errno));
+        return false;
+    }
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                 ring_fd_, IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) {
+        reason = "Failed to map submission entries: " + std::string(strerror(errno));
+        return false;
+    }
+
+    sq_head_ = ring_field(sq_ring_, params.sq_off.head);
+    sq_tail_ = ring_field(sq_ring_, params.sq_off.tail);
+    sq_mask_ = ring_field(sq_ring_, params.sq_off.ring_mask);
+    sq_array_ = ring_field(sq_ring_, params.sq_off.array);
+    cq_head_ = ring_field(cq_ring_, params.cq_off.head);
+    cq_tail_ = ring_field(cq_ring_, params.cq_off.tail);
+    cq_mask_ = ring_field(cq_ring_, params.cq_off.ring_mask);
+    cqes_ = static_cast<char*>(cq_ring_) + params.cq_off.cqes;
+
+    void* buffers = nullptr;
+    if (posix_memalign(&buffers, 4096, BUFFER_SIZE * BUFFER_COUNT) != 0) {
+        reason = "Failed to allocate I/O buffers";
+        return false;
+    }
+    buffers_ = static_cast<char*>(buffers);
+
+    // 注册固定缓冲区，省去每次写入时的页面映射；超出 RLIMIT_MEMLOCK 时退回普通写入
+    struct iovec iovecs[BUFFER_COUNT];
+    for (unsigned i = 0; i < BUFFER_COUNT; ++i) {
+        iovecs[i].iov_base = buffers_ + i * BUFFER_SIZE;
+        iovecs[i].iov_len = BUFFER_SIZE;
+    }
+    registered_ = io_uring_register(ring_fd_, IORING_REGISTER_BUFFERS, iovecs, BUFFER_COUNT) == 0;
+
+    // io_uring 早于 IORING_OP_WRITE（5.6）就已存在，旧内核上写入会以 EINVAL 失败；
+    // 用到的操作码都支持才启用，不支持探测的内核（早于 5.6）同样退回普通写入
+    std::vector<char> probe_buffer(sizeof(struct io_uring_probe) +
+                                   PROBE_OPS * sizeof(struct io_uring_probe_op));
+    struct io_uring_probe* probe = reinterpret_cast<struct io_uring_probe*>(probe_buffer.data());
+    if (io_uring_register(ring_fd_, IORING_REGISTER_PROBE, probe, PROBE_OPS) != 0) {
+        reason = "io_uring opcode probe failed: " + std::string(strerror(errno));
+        return false;
+    }
+    uint8_t write_op = registered_ ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    for (uint8_t op : {write_op, static_cast<uint8_t>(IORING_OP_FSYNC)}) {
+        if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+            reason = "io_uring opcode " + std::to_string(op) + " not supported by the kernel";
+            return false;
+        }
+    }
+    return true;
+}
+
+void UringQueue::queue(uint8_t opcode, int fd, unsigned slot, size_t length, off_t offset,
+                       uint8_t flags) {
+    // 队列长度大于缓冲区数加一个 fsync，积压的 SQE 不会填满队列
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & *sq_mask_;
+    struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(sqes_) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->flags = flags;
+    sqe->fd = fd;
+    if (opcode == IORING_OP_FSYNC) {
+        sqe->user_data = FSYNC_TAG;
+    } else {
+        sqe->addr = reinterpret_cast<uint64_t>(buffers_ + slot * BUFFER_SIZE);
+        sqe->len = static_cast<uint32_t>(length);
+        sqe->off = static_cast<uint64_t>(offset);
+        sqe->buf_index = static_cast<uint16_t>(slot);
+        sqe->user_data = slot;
+    }
+    sq_array_[index] = index;
+    // 没有 SQPOLL 线程，内核只在 io_uring_enter 中读取 tail，提前发布不会被提交
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+}
+
+bool UringQueue::enter(unsigned min_complete) {
+    unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    while (true) {
+        unsigned pending = *sq_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        if (pending == 0 && min_complete == 0) {
+            return true;
+        }
+        if (io_uring_enter(ring_fd_, pending, min_complete, flags) >= 0) {
+            // 内核只取走一部分时（如内存不足）不会等待完成就返回，剩下的留在队列中，
+            // 调用方的循环会再次进入，不会因等待永远不会提交的 SQE 而挂起
+            return true;
+        }
+        if (errno != EINTR) {
+            retract_unsubmitted(errno);
+            return false;
+        }
+    }
+}
+
+void UringQueue::retract_unsubmitted(int error) {
+    // head 之前的 SQE 已被内核取走，必会产生 CQE，其缓冲区要等 CQE 到达后才能复用；
+    // head 到 tail 之间的还在我们手里，把 tail 退回 head，内核再也不会看到它们
+    unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    for (unsigned i = head; i != *sq_tail_; ++i) {
+        const struct io_uring_sqe* sqe = static_cast<const struct io_uring_sqe*>(sqes_) + (i & *sq_mask_);
+        if (sqe->user_data == FSYNC_TAG) {
+            fsync_done_ = true;
+            fsync_result_ = -error;
+        } else {
+            slots_[sqe->user_data].busy = false;
+            --inflight_;
+        }
+    }
+    __atomic_store_n(sq_tail_, head, __ATOMIC_RELEASE);
+    error_ = error;
+}
+
+unsigned UringQueue::reap_ready() {
+    unsigned reaped = 0;
+    unsigned head = *cq_head_;
+    while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+        const struct io_uring_cqe* cqe =
+            static_cast<const struct io_uring_cqe*>(cqes_) + (head & *cq_mask_);
+        uint64_t user_data = cqe->user_data;
+        int32_t result = cqe->res;
+        __atomic_store_n(cq_head_, ++head, __ATOMIC_RELEASE);
+        complete(user_data, result);
+        ++reaped;
+    }
+    return reaped;
+}
+
+void UringQueue::complete(uint64_t user_data, int32_t result) {
+    if (user_data == FSYNC_TAG) {
+        fsync_done_ = true;
+        fsync_result_ = result;
+        return;
+    }
+
+    Slot& slot = slots_[user_data];
+    if (result < 0) {
+        error_ = -result;
+    } else if (static_cast<size_t>(result) < slot.length) {
+        // 短写极少发生，剩余部分同步补写
+        const char* data = buffers_ + user_data * BUFFER_SIZE;
+        size_t done = result;
+        while (done < slot.length) {
+            ssize_t written = pwrite(slot.fd, data + done, slot.length - done, slot.offset + done);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                error_ = written < 0 ? errno : EIO;
+                break;
+            }
+            done += written;
+        }
+    }
+    slot.busy = false;
+    --inflight_;
+}
+
+bool UringQueue::write(int fd, const char* data, size_t size, off_t offset) {
+    while (size > 0) {
+        if (error_ != 0) {
+            return false;
+        }
+        // 缓冲区全部占用：先收已完成的，仍然没有空闲时把积压的写入一起提交并等待一个完成
+        if (inflight_ == BUFFER_COUNT && reap_ready() == 0) {
+            if (!enter(1)) {
+                return false;
+            }
+            reap_ready();
+            continue;
+        }
+        while (slots_[next_slot_].busy) {
+            next_slot_ = (next_slot_ + 1) % BUFFER_COUNT;
+        }
+
+        unsigned index = next_slot_;
+        size_t length = std::min(size, BUFFER_SIZE);
+        memcpy(buffers_ + index * BUFFER_SIZE, data, length);
+        Slot& slot = slots_[index];
+        slot.busy = true;
+        slot.fd = fd;
+        slot.offset = offset;
+        slot.length = length;
+        ++inflight_;
+        queue(registered_ ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE, fd, index, length, offset, 0);
+
+        next_slot_ = (index + 1) % BUFFER_COUNT;
+        data += length;
+        size -= length;
+        offset += length;
+    }
+    return error_ == 0;
+}
+
+bool UringQueue::drain() {
+    // 积压的写入与等待全部完成合并为一次提交；提交失败时仍要等已被内核取走的写入完成，
+    // 否则缓冲区可能在内核读取前被复用
+    while (inflight_ > 0) {
+        reap_ready();
+        if (inflight_ > 0 && !enter(inflight_) && inflight_ > 0 &&
+            io_uring_enter(ring_fd_, 0, inflight_, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+            break;
+        }
+    }
+    // 本批写入的错误在此报告一次，之后的写入重新开始计数
+    bool ok = error_ == 0 && inflight_ == 0;
+    if (error_ != 0) {
+        last_error_ = error_;
+    }
+    if (inflight_ == 0) {
+        error_ = 0;
+    }
+    return ok;
+}
+
+bool UringQueue::fsync(int fd) {
+    // IOSQE_IO_DRAIN 保证 fsync 在之前提交的写入全部完成后才开始，积压的写入和 fsync 一起提交
+    fsync_done_ = false;
+    queue(IORING_OP_FSYNC, fd, 0, 0, 0, IOSQE_IO_DRAIN);
+    while (!fsync_done_) {
+        if (!enter(inflight_ + 1)) {
+            break;
+        }
+        reap_ready();
+    }
+    if (fsync_done_ && fsync_result_ < 0 && error_ == 0) {
+        error_ = -fsync_result_;
+    }
+    return drain() && fsync_done_;
+}
+
+#else
+
+UringQueue* UringQueue::create(std::string& reason) {
+    reason = "io_uring support not compiled in";
+    return nullptr;
+}
+
+UringQueue::~UringQueue() {}
+
+bool UringQueue::write(int, const char*, size_t, off_t) {
+    return false;
+}
+
+bool UringQueue::drain() {
+    return false;
+}
+
+bool UringQueue::fsync(int) {
+    return false;
+}
+
+#endif // WEBDAV_HAVE_IO_URING
+
+} // namespace webdav
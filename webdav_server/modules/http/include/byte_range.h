@@ -0,0 +1,30 @@
+#ifndef BYTE_RANGE_H
+#define BYTE_RANGE_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace webdav {
+
+enum class RangeResult {
+    IGNORE,          // 没有或无法识别的 Range，返回整个文件
+    UNSATISFIABLE,   // 所有范围都超出文件，返回 416
+    SATISFIABLE
+};
+
+typedef std::pair<size_t, size_t> ByteRange;  // [first, last]
+
+// 解析十进制长度（Content-Length、Range 等头部中的数值），只接受数字，溢出时返回 false
+bool parse_size(const std::string& value, size_t& result);
+
+// 解析 "bytes=0-99,200-,-500"，结果按起点排序并合并重叠和相邻的区间
+RangeResult parse_range_header(const std::string& value, size_t file_size,
+                               std::vector<ByteRange>& ranges);
+
+// Content-Range 头部的值："bytes first-last/size"
+std::string content_range(const ByteRange& range, size_t file_size);
+
+} // namespace webdav
+
+#endif // BYTE_RANGE_H
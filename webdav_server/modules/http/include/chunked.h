@@ -0,0 +1,75 @@
+#ifndef CHUNKED_H
+#define CHUNKED_H
+
+#include "http_types.h"
+#include <string>
+#include <vector>
+
+namespace webdav {
+
+// 增量解码 Transfer-Encoding: chunked 请求体，输入可以在任意位置被切开
+class ChunkedDecoder {
+public:
+    enum class Status {
+        OK,      // 输入已用完或输出已写满，需继续调用
+        DONE,    // 收到结束块和 trailer，请求体结束
+        ERROR
+    };
+
+    ChunkedDecoder();
+
+    // 解码 input，把请求体内容写入 output（最多 output_size 字节）
+    // consumed 返回消耗的输入字节数，produced 返回写入 output 的字节数
+    Status decode(const char* input, size_t input_size, size_t& consumed,
+                  char* output, size_t output_size, size_t& produced);
+    void reset();
+
+    bool done() const { return state_ == State::DONE; }
+    const std::string& error() const { return error_; }
+
+private:
+    enum class State {
+        SIZE,           // 块大小（十六进制）
+        EXTENSION,      // 块扩展，忽略
+        SIZE_LF,
+        DATA,
+        DATA_CR,
+        DATA_LF,
+        TRAILER_START,  // trailer 行首，空行表示结束
+        TRAILER_LINE,   // trailer 字段，忽略
+        TRAILER_LF,
+        FINAL_LF,
+        DONE
+    };
+
+    Status fail(const char* message);
+
+    State state_;
+    size_t chunk_remaining_;
+    size_t size_digits_;
+    size_t line_length_;     // 当前块扩展或 trailer 行的长度，防止无限长的行
+    size_t trailer_size_;
+    std::string error_;
+};
+
+// 以 chunked 编码输出响应体：数据先在缓冲区中攒成块，每块一次写出
+class ChunkedEncoder {
+public:
+    ChunkedEncoder(const BodyWriter& output, size_t chunk_size = 64 * 1024);
+
+    bool write(const char* data, size_t size);
+    // 写出剩余数据和结束块
+    bool finish();
+
+private:
+    bool flush_chunk();
+
+    BodyWriter output_;
+    size_t chunk_size_;
+    std::vector<char> buffer_;   // 开头预留块大小行的位置，块数据之后追加 CRLF
+    size_t used_;
+};
+
+} // namespace webdav
+
+#endif // CHUNKED_H
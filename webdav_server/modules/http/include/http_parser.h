@@ -11,14 +11,11 @@ public:
     HTTPParser(Logger& logger) : logger_(logger) {}
     ~HTTPParser();
 
-    bool parse_request(const std::vector<char>& raw_data, HTTPRequest& request);
     std::vector<char> build_response(const HTTPResponse& response);
+    // 只生成状态行和头部，响应体由调用方另行发送
+    std::string build_response_header(const HTTPResponse& response);
 
 private:
-    HTTPMethod parse_method(const std::string& method_str);
-    bool parse_request_line(const std::string& line, HTTPRequest& request);
-    bool parse_headers(std::istringstream& stream, std::map<std::string, std::string>& headers);
-
     Logger& logger_;
 };
 
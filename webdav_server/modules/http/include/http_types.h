@@ -4,9 +4,63 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <functional>
+#include <cstring>
+#include <strings.h>
 
 namespace webdav {
 
+// 指向外部缓冲区的只读字符串片段，不持有数据
+struct StringView {
+    const char* data;
+    size_t size;
+
+    StringView() : data(nullptr), size(0) {}
+    StringView(const char* d, size_t s) : data(d), size(s) {}
+
+    std::string str() const { return std::string(data, size); }
+    bool equals_ignore_case(const char* other) const {
+        return strlen(other) == size && strncasecmp(data, other, size) == 0;
+    }
+};
+
+// 请求头列表：名称不区分大小写，同名头部取最后一个。头部只有几十个，按顺序查找即可；
+// clear 不释放已有的字符串，同一连接上的后续请求复用它们，常见情况下不再分配内存
+class HeaderMap {
+public:
+    typedef std::pair<std::string, std::string> value_type;
+    typedef std::vector<value_type>::const_iterator const_iterator;
+
+    HeaderMap() : size_(0) {}
+
+    void clear() { size_ = 0; }
+    void add(const char* name, size_t name_length, const char* value, size_t value_length) {
+        if (size_ == entries_.size()) {
+            entries_.push_back(value_type());
+        }
+        entries_[size_].first.assign(name, name_length);
+        entries_[size_].second.assign(value, value_length);
+        ++size_;
+    }
+
+    const_iterator begin() const { return entries_.begin(); }
+    const_iterator end() const { return entries_.begin() + size_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const_iterator find(const char* name) const {
+        for (size_t i = size_; i > 0; --i) {
+            if (strcasecmp(entries_[i - 1].first.c_str(), name) == 0) {
+                return entries_.begin() + (i - 1);
+            }
+        }
+        return end();
+    }
+
+private:
+    std::vector<value_type> entries_;
+    size_t size_;
+};
+
 enum class HTTPMethod {
     GET,
     PUT,
@@ -24,12 +78,48 @@ enum class HTTPMethod {
     UNKNOWN
 };
 
+// 流式请求体，由连接层实现，处理函数按块读取而不必把整个请求体放进内存
+class BodyReader {
+public:
+    virtual ~BodyReader() {}
+    // 最多读取 size 字节，bytes_read 为 0 表示请求体已读完；出错返回 false
+    virtual bool read(char* buffer, size_t size, size_t& bytes_read) = 0;
+    // read 失败是因为客户端发送过慢（低于最低速率或长时间无数据）
+    virtual bool timed_out() const { return false; }
+};
+
+// 流式响应体的输出函数，返回 false 表示发送失败，调用方应停止输出
+typedef std::function<bool(const char* data, size_t size)> BodyWriter;
+
 struct HTTPRequest {
     HTTPMethod method;
     std::string uri;
     std::string version;
-    std::map<std::string, std::string> headers;
+    HeaderMap headers;
     std::vector<char> body;
+    BodyReader* body_reader;   // 非空时请求体需通过它读取，body 为空
+
+    HTTPRequest() : method(HTTPMethod::UNKNOWN), body_reader(nullptr) {}
+
+    // 为同一连接上的下一个请求清空：字符串和头部保留已分配的空间，请求体可能很大，不保留
+    void clear() {
+        method = HTTPMethod::UNKNOWN;
+        uri.clear();
+        version.clear();
+        headers.clear();
+        std::vector<char>().swap(body);
+        body_reader = nullptr;
+    }
+};
+
+// 文件响应体中的一段：先发送 prefix（如 multipart 分段头），再发送文件 [offset, offset + length)
+struct FileSegment {
+    std::string prefix;
+    size_t offset;
+    size_t length;
+
+    FileSegment(size_t off, size_t len, const std::string& pre = std::string())
+        : prefix(pre), offset(off), length(len) {}
 };
 
 struct HTTPResponse {
@@ -37,6 +127,29 @@ struct HTTPResponse {
     std::string status_message;
     std::map<std::string, std::string> headers;
     std::vector<char> body;
+
+    // 文件响应体：file_fd >= 0 时按 file_segments 以 sendfile 从该 fd 发送，
+    // 最后发送 file_trailer，发送后由服务器关闭 fd
+    int file_fd;
+    std::vector<FileSegment> file_segments;
+    std::string file_trailer;
+
+    // 流式响应体：非空时由服务器在发送头部后调用，总长度事先未知，
+    // HTTP/1.1 下以 chunked 编码发送，HTTP/1.0 下以关闭连接结束
+    std::function<bool(const BodyWriter& write)> body_producer;
+
+    HTTPResponse() : status_code(0), file_fd(-1) {}
+
+    size_t body_length() const {
+        if (file_fd < 0) {
+            return body.size();
+        }
+        size_t length = file_trailer.size();
+        for (const auto& segment : file_segments) {
+            length += segment.prefix.size() + segment.length;
+        }
+        return length;
+    }
 };
 
 } // namespace webdav
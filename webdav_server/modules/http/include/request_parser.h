@@ -0,0 +1,103 @@
+#ifndef REQUEST_PARSER_H
+#define REQUEST_PARSER_H
+
+#include "http_types.h"
+
+namespace webdav {
+
+// 可续传的请求头解析器：数据分多次到达时从上次停下的位置继续，
+// 每个字节只处理一次；各字段只记录在连接缓冲区中的偏移，不复制数据。
+// 偏移与缓冲区地址无关，缓冲区扩容后仍然有效。
+class RequestParser {
+public:
+    enum class Status {
+        INCOMPLETE,
+        COMPLETE,
+        ERROR
+    };
+
+    struct Span {
+        size_t offset;
+        size_t length;
+    };
+
+    struct Header {
+        Span name;
+        Span value;
+    };
+
+    static const size_t MAX_HEADERS = 64;
+
+    RequestParser();
+
+    void reset();
+    // data 为缓冲区起始地址，size 为当前数据长度，只处理上次调用之后新增的部分
+    Status parse(const char* data, size_t size);
+
+    Status status() const { return status_; }
+    size_t header_size() const { return header_size_; }   // 请求头长度（含结尾空行）
+    const char* error() const { return error_; }
+
+    // 以下访问函数需传入同一缓冲区的当前地址
+    HTTPMethod method() const { return method_; }
+    StringView method_name(const char* data) const { return view(data, method_span_); }
+    StringView uri(const char* data) const { return view(data, uri_span_); }
+    StringView version(const char* data) const { return view(data, version_span_); }
+    size_t header_count() const { return header_count_; }
+    StringView header_name(const char* data, size_t index) const;
+    StringView header_value(const char* data, size_t index) const;
+    // 名称不区分大小写，同名头部取最后一个
+    bool find_header(const char* data, const char* name, StringView& value) const;
+    // 同名头部出现多次且取值不完全相同
+    bool has_conflicting_header(const char* data, const char* name) const;
+
+    // 请求头完整后转换为 HTTPRequest，只在这里复制数据（复用 request 中已分配的空间）
+    void to_request(const char* data, HTTPRequest& request) const;
+
+private:
+    enum class State {
+        START,
+        METHOD,
+        URI_START,
+        URI,
+        VERSION_START,
+        VERSION,
+        REQUEST_LINE_END,
+        HEADER_START,
+        HEADER_NAME,
+        HEADER_VALUE_START,
+        HEADER_VALUE,
+        HEADER_LINE_END,
+        HEADERS_END,
+        DONE
+    };
+
+    static StringView view(const char* data, const Span& span) {
+        return StringView(data + span.offset, span.length);
+    }
+
+    Status fail(const char* message);
+    Status finish(size_t end);
+    bool end_header();
+
+    State state_;
+    Status status_;
+    size_t pos_;
+    size_t header_size_;
+    const char* error_;
+
+    Span method_span_;
+    Span uri_span_;
+    Span version_span_;
+    HTTPMethod method_;
+
+    Header headers_[MAX_HEADERS];
+    size_t header_count_;
+    Header current_;
+    size_t value_end_;       // 当前头部值中最后一个非空白字符之后的位置
+    bool current_valid_;     // 当前头部值只含可打印字符
+};
+
+} // namespace webdav
+
+#endif // REQUEST_PARSER_H
@@ -0,0 +1,110 @@
+#include "byte_range.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+
+namespace webdav {
+
+namespace {
+
+const size_t MAX_RANGES = 32;               // 超过该数量的 Range 请求直接返回整个文件
+
+} // namespace
+
+bool parse_size(const std::string& value, size_t& result) {
+    if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    errno = 0;
+    result = static_cast<size_t>(strtoull(value.c_str(), nullptr, 10));
+    return errno != ERANGE;
+}
+
+RangeResult parse_range_header(const std::string& value, size_t file_size,
+                               std::vector<ByteRange>& ranges) {
+    if (value.compare(0, 6, "bytes=") != 0) {
+        return RangeResult::IGNORE;
+    }
+    
+    size_t pos = 6;
+    size_t spec_count = 0;
+    while (pos <= value.size()) {
+        size_t comma = value.find(',', pos);
+        if (comma == std::string::npos) {
+            comma = value.size();
+        }
+        std::string spec = value.substr(pos, comma - pos);
+        pos = comma + 1;
+        
+        spec.erase(0, spec.find_first_not_of(" \t"));
+        spec.erase(spec.find_last_not_of(" \t") + 1);
+        if (spec.empty()) {
+            continue;
+        }
+        if (++spec_count > MAX_RANGES) {
+            return RangeResult::IGNORE;
+        }
+        
+        size_t dash = spec.find('-');
+        if (dash == std::string::npos) {
+            return RangeResult::IGNORE;
+        }
+        std::string first_str = spec.substr(0, dash);
+        std::string last_str = spec.substr(dash + 1);
+        
+        size_t first = 0;
+        size_t last = 0;
+        if (first_str.empty()) {
+            // 后缀范围：最后 N 个字节
+            size_t suffix = 0;
+            if (!parse_size(last_str, suffix)) {
+                return RangeResult::IGNORE;
+            }
+            if (suffix == 0 || file_size == 0) {
+                continue;
+            }
+            first = suffix >= file_size ? 0 : file_size - suffix;
+            last = file_size - 1;
+        } else {
+            if (!parse_size(first_str, first)) {
+                return RangeResult::IGNORE;
+            }
+            if (last_str.empty()) {
+                last = file_size - 1;
+            } else if (!parse_size(last_str, last) || last < first) {
+                return RangeResult::IGNORE;
+            }
+            if (first >= file_size) {
+                continue;
+            }
+            last = std::min(last, file_size - 1);
+        }
+        ranges.push_back(ByteRange(first, last));
+    }
+    
+    if (spec_count == 0) {
+        return RangeResult::IGNORE;
+    }
+    if (ranges.empty()) {
+        return RangeResult::UNSATISFIABLE;
+    }
+    
+    std::sort(ranges.begin(), ranges.end());
+    std::vector<ByteRange> merged;
+    for (const auto& range : ranges) {
+        if (!merged.empty() && range.first <= merged.back().second + 1) {
+            merged.back().second = std::max(merged.back().second, range.second);
+        } else {
+            merged.push_back(range);
+        }
+    }
+    ranges.swap(merged);
+    return RangeResult::SATISFIABLE;
+}
+
+std::string content_range(const ByteRange& range, size_t file_size) {
+    return "bytes " + std::to_string(range.first) + "-" + std::to_string(range.second) +
+           "/" + std::to_string(file_size);
+}
+
+} // namespace webdav
@@ -0,0 +1,191 @@
+#include "chunked.h"
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+
+namespace webdav {
+
+namespace {
+
+const size_t MAX_LINE_LENGTH = 4096;        // 单个块扩展或 trailer 行的上限
+const size_t MAX_TRAILER_SIZE = 16 * 1024;  // trailer 总长度上限
+const size_t SIZE_LINE_RESERVE = 18;        // 16 位十六进制块大小 + CRLF
+const char LAST_CHUNK[] = "0\r\n\r\n";
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace
+
+ChunkedDecoder::ChunkedDecoder() {
+    reset();
+}
+
+void ChunkedDecoder::reset() {
+    state_ = State::SIZE;
+    chunk_remaining_ = 0;
+    size_digits_ = 0;
+    line_length_ = 0;
+    trailer_size_ = 0;
+    error_.clear();
+}
+
+ChunkedDecoder::Status ChunkedDecoder::fail(const char* message) {
+    error_ = message;
+    return Status::ERROR;
+}
+
+ChunkedDecoder::Status ChunkedDecoder::decode(const char* input, size_t input_size, size_t& consumed,
+                                              char* output, size_t output_size, size_t& produced) {
+    consumed = 0;
+    produced = 0;
+    if (!error_.empty()) {
+        return Status::ERROR;
+    }
+
+    while (state_ != State::DONE && consumed < input_size) {
+        if (state_ == State::DATA) {
+            // 块数据整段拷贝，不逐字节处理
+            size_t count = std::min(std::min(chunk_remaining_, input_size - consumed),
+                                    output_size - produced);
+            if (count == 0) {
+                break;  // 输出已写满
+            }
+            memcpy(output + produced, input + consumed, count);
+            consumed += count;
+            produced += count;
+            chunk_remaining_ -= count;
+            if (chunk_remaining_ == 0) {
+                state_ = State::DATA_CR;
+            }
+            continue;
+        }
+
+        char c = input[consumed++];
+        switch (state_) {
+        case State::SIZE: {
+            int digit = hex_value(c);
+            if (digit >= 0) {
+                if (chunk_remaining_ > (SIZE_MAX >> 4)) {
+                    return fail("Chunk size too large");
+                }
+                chunk_remaining_ = (chunk_remaining_ << 4) | digit;
+                ++size_digits_;
+            } else if (size_digits_ == 0) {
+                return fail("Invalid chunk size");
+            } else if (c == '\r') {
+                state_ = State::SIZE_LF;
+            } else if (c == ';' || c == ' ' || c == '\t') {
+                state_ = State::EXTENSION;
+                line_length_ = 0;
+            } else {
+                return fail("Invalid chunk size");
+            }
+            break;
+        }
+        case State::EXTENSION:
+            if (c == '\r') {
+                state_ = State::SIZE_LF;
+            } else if (++line_length_ > MAX_LINE_LENGTH) {
+                return fail("Chunk extension too long");
+            }
+            break;
+        case State::SIZE_LF:
+            if (c != '\n') {
+                return fail("Expected LF after chunk size");
+            }
+            size_digits_ = 0;
+            state_ = chunk_remaining_ == 0 ? State::TRAILER_START : State::DATA;
+            break;
+        case State::DATA_CR:
+            if (c != '\r') {
+                return fail("Expected CRLF after chunk data");
+            }
+            state_ = State::DATA_LF;
+            break;
+        case State::DATA_LF:
+            if (c != '\n') {
+                return fail("Expected CRLF after chunk data");
+            }
+            state_ = State::SIZE;
+            break;
+        case State::TRAILER_START:
+            if (c == '\r') {
+                state_ = State::FINAL_LF;
+                break;
+            }
+            state_ = State::TRAILER_LINE;
+            line_length_ = 0;
+            // fall through
+        case State::TRAILER_LINE:
+            if (c == '\r') {
+                state_ = State::TRAILER_LF;
+            } else if (++line_length_ > MAX_LINE_LENGTH || ++trailer_size_ > MAX_TRAILER_SIZE) {
+                return fail("Trailer too large");
+            }
+            break;
+        case State::TRAILER_LF:
+            if (c != '\n') {
+                return fail("Expected LF after trailer field");
+            }
+            state_ = State::TRAILER_START;
+            break;
+        case State::FINAL_LF:
+            if (c != '\n') {
+                return fail("Expected LF after last chunk");
+            }
+            state_ = State::DONE;
+            break;
+        default:
+            break;
+        }
+    }
+
+    return state_ == State::DONE ? Status::DONE : Status::OK;
+}
+
+ChunkedEncoder::ChunkedEncoder(const BodyWriter& output, size_t chunk_size)
+    : output_(output), chunk_size_(chunk_size),
+      buffer_(SIZE_LINE_RESERVE + chunk_size + 2), used_(0) {}
+
+bool ChunkedEncoder::write(const char* data, size_t size) {
+    while (size > 0) {
+        size_t count = std::min(size, chunk_size_ - used_);
+        memcpy(buffer_.data() + SIZE_LINE_RESERVE + used_, data, count);
+        used_ += count;
+        data += count;
+        size -= count;
+        if (used_ == chunk_size_ && !flush_chunk()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ChunkedEncoder::finish() {
+    if (used_ > 0 && !flush_chunk()) {
+        return false;
+    }
+    return output_(LAST_CHUNK, sizeof(LAST_CHUNK) - 1);
+}
+
+bool ChunkedEncoder::flush_chunk() {
+    // 块大小行紧贴在数据之前写入预留区，整块连同结尾 CRLF 一次输出
+    char size_line[SIZE_LINE_RESERVE + 1];
+    int length = snprintf(size_line, sizeof(size_line), "%zx\r\n", used_);
+    char* start = buffer_.data() + SIZE_LINE_RESERVE - length;
+    memcpy(start, size_line, length);
+    char* end = buffer_.data() + SIZE_LINE_RESERVE + used_;
+    end[0] = '\r';
+    end[1] = '\n';
+
+    size_t total = length + used_ + 2;
+    used_ = 0;
+    return output_(start, total);
+}
+
+} // namespace webdav
@@ -0,0 +1,297 @@
+#include "request_parser.h"
+#include <cstring>
+#include <strings.h>
+
+namespace webdav {
+
+namespace {
+
+const size_t MAX_METHOD_LENGTH = 16;
+
+struct MethodEntry {
+    const char* name;
+    size_t length;
+    HTTPMethod method;
+};
+
+const MethodEntry METHODS[] = {
+    {"GET", 3, HTTPMethod::GET},
+    {"PUT", 3, HTTPMethod::PUT},
+    {"HEAD", 4, HTTPMethod::HEAD},
+    {"POST", 4, HTTPMethod::POST},
+    {"COPY", 4, HTTPMethod::COPY},
+    {"MOVE", 4, HTTPMethod::MOVE},
+    {"LOCK", 4, HTTPMethod::LOCK},
+    {"MKCOL", 5, HTTPMethod::MKCOL},
+    {"DELETE", 6, HTTPMethod::DELETE},
+    {"UNLOCK", 6, HTTPMethod::UNLOCK},
+    {"OPTIONS", 7, HTTPMethod::OPTIONS},
+    {"PROPFIND", 8, HTTPMethod::PROPFIND},
+    {"PROPPATCH", 9, HTTPMethod::PROPPATCH}
+};
+
+HTTPMethod lookup_method(const char* name, size_t length) {
+    for (const auto& entry : METHODS) {
+        if (entry.length == length && memcmp(entry.name, name, length) == 0) {
+            return entry.method;
+        }
+    }
+    return HTTPMethod::UNKNOWN;
+}
+
+// RFC 7230 token 字符
+bool is_token_char(unsigned char c) {
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) {
+        return true;
+    }
+    return c != 0 && strchr("!#$%&'*+-.^_`|~", c) != nullptr;
+}
+
+bool is_visible_char(unsigned char c) {
+    return c > 32 && c < 127;
+}
+
+} // namespace
+
+RequestParser::RequestParser() {
+    reset();
+}
+
+void RequestParser::reset() {
+    state_ = State::START;
+    status_ = Status::INCOMPLETE;
+    pos_ = 0;
+    header_size_ = 0;
+    error_ = "";
+    method_span_.offset = method_span_.length = 0;
+    uri_span_ = version_span_ = method_span_;
+    method_ = HTTPMethod::UNKNOWN;
+    header_count_ = 0;
+    current_.name = current_.value = method_span_;
+    value_end_ = 0;
+    current_valid_ = true;
+}
+
+RequestParser::Status RequestParser::fail(const char* message) {
+    error_ = message;
+    status_ = Status::ERROR;
+    return status_;
+}
+
+RequestParser::Status RequestParser::finish(size_t end) {
+    header_size_ = end;
+    pos_ = end;
+    state_ = State::DONE;
+    status_ = Status::COMPLETE;
+    return status_;
+}
+
+bool RequestParser::end_header() {
+    // 与旧解析器一致：值中含不可打印字符的头部直接丢弃
+    if (!current_valid_) {
+        return true;
+    }
+    if (header_count_ >= MAX_HEADERS) {
+        fail("Too many headers");
+        return false;
+    }
+    headers_[header_count_++] = current_;
+    return true;
+}
+
+RequestParser::Status RequestParser::parse(const char* data, size_t size) {
+    if (status_ != Status::INCOMPLETE) {
+        return status_;
+    }
+    
+    for (; pos_ < size; ++pos_) {
+        unsigned char c = static_cast<unsigned char>(data[pos_]);
+        switch (state_) {
+            case State::START:
+                // 忽略请求行之前的空行
+                if (c == '\r' || c == '\n') {
+                    break;
+                }
+                if (!is_token_char(c)) {
+                    return fail("Invalid method");
+                }
+                method_span_.offset = pos_;
+                state_ = State::METHOD;
+                break;
+                
+            case State::METHOD:
+                if (c == ' ') {
+                    method_span_.length = pos_ - method_span_.offset;
+                    method_ = lookup_method(data + method_span_.offset, method_span_.length);
+                    state_ = State::URI_START;
+                } else if (!is_token_char(c) || pos_ - method_span_.offset >= MAX_METHOD_LENGTH) {
+                    return fail("Invalid method");
+                }
+                break;
+                
+            case State::URI_START:
+                if (c == ' ') {
+                    break;
+                }
+                if (!is_visible_char(c)) {
+                    return fail("Invalid request URI");
+                }
+                uri_span_.offset = pos_;
+                state_ = State::URI;
+                break;
+                
+            case State::URI:
+                if (c == ' ') {
+                    uri_span_.length = pos_ - uri_span_.offset;
+                    state_ = State::VERSION_START;
+                } else if (!is_visible_char(c)) {
+                    return fail("Invalid request URI");
+                }
+                break;
+                
+            case State::VERSION_START:
+                if (c == ' ') {
+                    break;
+                }
+                if (!is_visible_char(c)) {
+                    return fail("Missing HTTP version");
+                }
+                version_span_.offset = pos_;
+                state_ = State::VERSION;
+                break;
+                
+            case State::VERSION:
+                if (c == '\r' || c == '\n') {
+                    version_span_.length = pos_ - version_span_.offset;
+                    state_ = c == '\r' ? State::REQUEST_LINE_END : State::HEADER_START;
+                } else if (!is_visible_char(c)) {
+                    return fail("Invalid HTTP version");
+                }
+                break;
+                
+            case State::REQUEST_LINE_END:
+            case State::HEADER_LINE_END:
+                if (c != '\n') {
+                    return fail("Invalid line ending");
+                }
+                state_ = State::HEADER_START;
+                break;
+                
+            case State::HEADER_START:
+                if (c == '\r') {
+                    state_ = State::HEADERS_END;
+                    break;
+                }
+                if (c == '\n') {
+                    return finish(pos_ + 1);
+                }
+                if (c == ' ' || c == '\t') {
+                    return fail("Obsolete header line folding");
+                }
+                if (!is_token_char(c)) {
+                    return fail("Invalid header name");
+                }
+                current_.name.offset = pos_;
+                state_ = State::HEADER_NAME;
+                break;
+                
+            case State::HEADER_NAME:
+                if (c == ':') {
+                    current_.name.length = pos_ - current_.name.offset;
+                    state_ = State::HEADER_VALUE_START;
+                } else if (!is_token_char(c)) {
+                    return fail("Invalid header name");
+                }
+                break;
+                
+            case State::HEADER_VALUE_START:
+                if (c == ' ' || c == '\t') {
+                    break;
+                }
+                current_.value.offset = pos_;
+                value_end_ = pos_;
+                current_valid_ = true;
+                state_ = State::HEADER_VALUE;
+                // fall through
+                
+            case State::HEADER_VALUE:
+                if (c == '\r' || c == '\n') {
+                    current_.value.length = value_end_ - current_.value.offset;
+                    if (!end_header()) {
+                        return status_;
+                    }
+                    state_ = c == '\r' ? State::HEADER_LINE_END : State::HEADER_START;
+                } else if (c != ' ' && c != '\t') {
+                    value_end_ = pos_ + 1;
+                    if (c < 32 || c > 126) {
+                        current_valid_ = false;
+                    }
+                }
+                break;
+                
+            case State::HEADERS_END:
+                if (c != '\n') {
+                    return fail("Invalid line ending");
+                }
+                return finish(pos_ + 1);
+                
+            case State::DONE:
+                return status_;
+        }
+    }
+    
+    return status_;
+}
+
+StringView RequestParser::header_name(const char* data, size_t index) const {
+    return view(data, headers_[index].name);
+}
+
+StringView RequestParser::header_value(const char* data, size_t index) const {
+    return view(data, headers_[index].value);
+}
+
+bool RequestParser::find_header(const char* data, const char* name, StringView& value) const {
+    size_t length = strlen(name);
+    for (size_t i = header_count_; i > 0; --i) {
+        const Header& header = headers_[i - 1];
+        if (header.name.length == length &&
+            strncasecmp(data + header.name.offset, name, length) == 0) {
+            value = view(data, header.value);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RequestParser::has_conflicting_header(const char* data, const char* name) const {
+    size_t length = strlen(name);
+    const Header* first = nullptr;
+    for (size_t i = 0; i < header_count_; ++i) {
+        const Header& header = headers_[i];
+        if (header.name.length != length || strncasecmp(data + header.name.offset, name, length) != 0) {
+            continue;
+        }
+        if (!first) {
+            first = &header;
+        } else if (header.value.length != first->value.length ||
+                   memcmp(data + header.value.offset, data + first->value.offset, header.value.length) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void RequestParser::to_request(const char* data, HTTPRequest& request) const {
+    request.method = method_;
+    request.uri.assign(data + uri_span_.offset, uri_span_.length);
+    request.version.assign(data + version_span_.offset, version_span_.length);
+    request.headers.clear();
+    for (size_t i = 0; i < header_count_; ++i) {
+        const Header& header = headers_[i];
+        request.headers.add(data + header.name.offset, header.name.length,
+                            data + header.value.offset, header.value.length);
+    }
+}
+
+} // namespace webdav
@@ -9,6 +9,8 @@ namespace webdav {
 class MimeTypes {
 public:
     static std::string get_mime_type(const std::string& path);
+    // 与 get_mime_type 相同，但返回表中字符串的引用，不产生拷贝
+    static const std::string& lookup(const std::string& path);
     
 private:
     static std::map<std::string, std::string> mime_types;
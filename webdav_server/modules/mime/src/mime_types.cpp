@@ -42,15 +42,21 @@ void MimeTypes::init_mime_types() {
 }
 
 std::string MimeTypes::get_mime_type(const std::string& path) {
-    if (!initialized) {
-        init_mime_types();
-    }
+    return lookup(path);
+}
+
+const std::string& MimeTypes::lookup(const std::string& path) {
+    // 局部静态变量的初始化是线程安全的，多个工作线程首次并发调用时也只初始化一次
+    static const bool ready = (init_mime_types(), true);
+    static const std::string default_type = "application/octet-stream";
+    (void)ready;
     
     size_t pos = path.find_last_of('.');
-    if (pos == std::string::npos) {
-        return "application/octet-stream";
+    if (pos == std::string::npos || path.size() - pos > 8) {
+        return default_type;
     }
     
+    // 扩展名很短，小写副本放在 SSO 缓冲区中，不分配内存
     std::string ext = path.substr(pos);
     std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
     
@@ -59,7 +65,7 @@ std::string MimeTypes::get_mime_type(const std::string& path) {
         return it->second;
     }
     
-    return "application/octet-stream";
+    return default_type;
 }
 
-} // namespace webdav 
\ No newline at end of file
+} // namespace webdav 
@@ -0,0 +1,62 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+
+namespace webdav {
+
+// 固定大小的工作线程池，请求队列有上限
+class ThreadPool {
+public:
+    struct Stats {
+        size_t threads;
+        size_t queue_capacity;
+        size_t queue_depth;       // 当前排队的任务数
+        size_t active;            // 正在执行的任务数
+        uint64_t completed;
+        uint64_t rejected;        // 因队列已满被拒绝的任务数
+        uint64_t avg_wait_us;     // 排队时间的滑动平均（微秒）
+        uint64_t max_wait_us;     // 排队时间的最大值（微秒）
+    };
+
+    // thread_count 为 0 时按 CPU 核数创建
+    ThreadPool(size_t thread_count, size_t queue_capacity);
+    ~ThreadPool();
+
+    // 队列已满或线程池已关闭时返回 false
+    bool submit(std::function<void()> task);
+    void shutdown();
+    Stats get_stats();
+
+private:
+    struct Task {
+        std::function<void()> func;
+        std::chrono::steady_clock::time_point enqueue_time;
+    };
+
+    void worker_loop();
+
+    std::vector<std::thread> threads_;
+    std::deque<Task> queue_;
+    size_t queue_capacity_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_;
+
+    size_t active_;
+    uint64_t completed_;
+    uint64_t rejected_;
+    uint64_t avg_wait_us_;
+    uint64_t max_wait_us_;
+};
+
+} // namespace webdav
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,109 @@
+#include "thread_pool.h"
+
+namespace webdav {
+
+ThreadPool::ThreadPool(size_t thread_count, size_t queue_capacity)
+    : queue_capacity_(queue_capacity), stopping_(false), active_(0),
+      completed_(0), rejected_(0), avg_wait_us_(0), max_wait_us_(0) {
+    if (thread_count == 0) {
+        thread_count = std::thread::hardware_concurrency();
+        if (thread_count == 0) {
+            thread_count = 1;
+        }
+    }
+    
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads_.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    shutdown();
+}
+
+bool ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || queue_.size() >= queue_capacity_) {
+            ++rejected_;
+            return false;
+        }
+        
+        Task entry;
+        entry.func = std::move(task);
+        entry.enqueue_time = std::chrono::steady_clock::now();
+        queue_.push_back(std::move(entry));
+    }
+    cv_.notify_one();
+    return true;
+}
+
+void ThreadPool::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+        queue_.clear();
+    }
+    cv_.notify_all();
+    
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+ThreadPool::Stats ThreadPool::get_stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.threads = threads_.size();
+    stats.queue_capacity = queue_capacity_;
+    stats.queue_depth = queue_.size();
+    stats.active = active_;
+    stats.completed = completed_;
+    stats.rejected = rejected_;
+    stats.avg_wait_us = avg_wait_us_;
+    stats.max_wait_us = max_wait_us_;
+    return stats;
+}
+
+void ThreadPool::worker_loop() {
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            task = std::move(queue_.front());
+            queue_.pop_front();
+            
+            // 记录排队时间，滑动平均权重 1/8
+            uint64_t wait_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - task.enqueue_time).count();
+            avg_wait_us_ = avg_wait_us_ - avg_wait_us_ / 8 + wait_us / 8;
+            if (wait_us > max_wait_us_) {
+                max_wait_us_ = wait_us;
+            }
+            ++active_;
+        }
+        
+        try {
+            task.func();
+        } catch (...) {
+            // 任务自行处理异常，这里只保证工作线程不退出
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --active_;
+            ++completed_;
+        }
+    }
+}
+
+} // namespace webdav
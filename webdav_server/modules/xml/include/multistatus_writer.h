@@ -0,0 +1,61 @@
+#ifndef MULTISTATUS_WRITER_H
+#define MULTISTATUS_WRITER_H
+
+#include <string>
+#include <ctime>
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include "file_types.h"
+#include "propfind.h"
+
+namespace webdav {
+
+// PROPFIND 多状态响应的生成器：所有内容追加到同一个可复用的缓冲区，
+// 固定片段预先拼好，整数和日期手工格式化，不经过 stringstream 和 strftime
+class MultistatusWriter {
+public:
+    explicit MultistatusWriter(size_t reserve = 64 * 1024);
+
+    // XML 声明和 <D:multistatus> 开始标签
+    void begin();
+    // 一个资源的 <D:response>：href 由已编码的 base_href 加上未编码的相对路径 path_suffix 组成，
+    // 只生成 request 要求的属性，请求了但不存在的属性放在 404 的 propstat 中
+    void add_response(const std::string& base_href, const std::string& path_suffix, const FileInfo& info,
+                      const PropfindRequest& request);
+    // 只有状态的 <D:response>，error_element 非空时附带 <D:error>
+    void add_status(const std::string& href, const char* status_line, const char* error_element);
+    // 目录树中某个成员的状态（用于 COPY/DELETE 的部分失败），href 的组成同 add_response
+    void add_member_status(const std::string& base_href, const std::string& path_suffix, const char* status_line);
+    // 逐段生成 <D:response>：每个 propstat 列出一组属性名及其共同的状态（用于 PROPPATCH）
+    void begin_response(const std::string& href);
+    void add_propstat(const std::vector<std::pair<std::string, std::string>>& names, const char* status_line);
+    void end_response();
+    void end();
+
+    const char* data() const { return buffer_.data(); }
+    size_t size() const { return buffer_.size(); }
+    // 清空内容但保留已分配的容量，供分批发送时复用
+    void clear() { buffer_.clear(); }
+
+private:
+    void append(const char* data, size_t size) { buffer_.append(data, size); }
+    template <size_t N>
+    void append_literal(const char (&text)[N]) { buffer_.append(text, N - 1); }
+    void append_escaped(const std::string& text, bool attribute = false);
+    void append_live_props(const FileInfo& info, unsigned props, bool names_only);
+    // 输出属性元素，value 为空指针时输出空元素；非 DAV: 命名空间在元素上就地声明
+    void append_property(const std::string& ns, const std::string& local, const std::string* value);
+    void append_dead_property(const std::string& key, const std::string* value);
+    void append_propstat_end(const char* status_line);
+    void append_path_encoded(const std::string& path);
+    void append_uint(uint64_t value);
+    void append_http_date(time_t t);
+    void append_iso_date(time_t t);
+
+    std::string buffer_;
+};
+
+} // namespace webdav
+
+#endif // MULTISTATUS_WRITER_H
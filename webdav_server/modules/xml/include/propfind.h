@@ -0,0 +1,52 @@
+#ifndef PROPFIND_H
+#define PROPFIND_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <memory>
+#include "xml_types.h"
+
+namespace webdav {
+
+// 服务器计算的活属性，每个占一位，便于按请求只生成需要的部分
+enum LiveProperty : unsigned {
+    PROP_RESOURCETYPE     = 1u << 0,
+    PROP_GETCONTENTLENGTH = 1u << 1,
+    PROP_GETLASTMODIFIED  = 1u << 2,
+    PROP_CREATIONDATE     = 1u << 3,
+    PROP_GETETAG          = 1u << 4,
+    PROP_GETCONTENTTYPE   = 1u << 5,
+    PROP_DISPLAYNAME      = 1u << 6,
+    PROP_SUPPORTEDLOCK    = 1u << 7,
+    PROP_ALL_LIVE         = (1u << 8) - 1
+};
+
+// 解析后的 PROPFIND 请求体
+struct PropfindRequest {
+    enum Mode {
+        ALL_PROP,    // <allprop/> 或空请求体：所有活属性和死属性
+        PROP_NAME,   // <propname/>：只列出属性名
+        PROP         // <prop>...</prop>：只返回点名的属性
+    };
+
+    Mode mode;
+    unsigned live_props;  // PROP 模式下请求的活属性
+    // PROP 模式下请求的其他属性（命名空间, 本地名），存在同名死属性时返回其值，否则归入 404
+    std::vector<std::pair<std::string, std::string>> other_props;
+
+    PropfindRequest() : mode(ALL_PROP), live_props(PROP_ALL_LIVE) {}
+};
+
+// 由已解析的 XML 文档构造 PROPFIND 请求，根元素不是 DAV:propfind 时返回 false
+bool build_propfind_request(const std::shared_ptr<XMLNode>& root, PropfindRequest& request);
+
+// ns/local 为服务器计算的活属性时返回对应的位，否则返回 0
+unsigned live_property_bit(const std::string& ns, const std::string& local);
+
+// 死属性以 Clark 记法 "{命名空间}本地名" 为键
+std::string clark_name(const std::string& ns, const std::string& local);
+
+} // namespace webdav
+
+#endif // PROPFIND_H
@@ -0,0 +1,24 @@
+#ifndef PROPPATCH_H
+#define PROPPATCH_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include "xml_types.h"
+
+namespace webdav {
+
+// PROPPATCH 中的一个操作，按文档顺序执行
+struct PropertyOperation {
+    bool remove;              // <remove> 为 true，<set> 为 false
+    std::string ns;
+    std::string local_name;
+    std::string value;        // 只保存文本内容
+};
+
+// 由已解析的 XML 文档取出 propertyupdate 中的操作，根元素不是 DAV:propertyupdate 时返回 false
+bool build_proppatch_request(const std::shared_ptr<XMLNode>& root, std::vector<PropertyOperation>& operations);
+
+} // namespace webdav
+
+#endif // PROPPATCH_H
@@ -10,6 +10,8 @@ public:
     XMLParser();
     ~XMLParser();
 
+    // 解析文档：跳过 XML 声明、注释、处理指令和 DOCTYPE，解码预定义实体和 CDATA，
+    // 并为每个节点解析命名空间
     bool parse(const std::string& xml, std::shared_ptr<XMLNode>& root);
     std::string build(const std::shared_ptr<XMLNode>& root);
 
@@ -17,6 +19,10 @@ private:
     bool parse_node(const std::string& xml, size_t& pos, std::shared_ptr<XMLNode>& node);
     bool parse_attributes(const std::string& xml, size_t& pos, std::map<std::string, std::string>& attributes);
     std::string get_tag_name(const std::string& xml, size_t& pos);
+    // 跳过注释、处理指令和 <!DOCTYPE>，没有可跳过的内容时返回 false
+    bool skip_markup(const std::string& xml, size_t& pos);
+    void resolve_namespaces(const std::shared_ptr<XMLNode>& node,
+                            std::map<std::string, std::string> scope);
 };
 
 } // namespace webdav
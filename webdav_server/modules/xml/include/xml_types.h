@@ -9,7 +9,9 @@
 namespace webdav {
 
 struct XMLNode {
-    std::string name;
+    std::string name;            // 原始的限定名，如 "D:prop"
+    std::string namespace_uri;   // 解析 xmlns 声明后的命名空间，如 "DAV:"
+    std::string local_name;      // 去掉前缀后的名称，如 "prop"
     std::string value;
     std::map<std::string, std::string> attributes;
     std::vector<std::shared_ptr<XMLNode>> children;
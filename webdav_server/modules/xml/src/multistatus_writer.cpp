@@ -0,0 +1,400 @@
+#include "multistatus_writer.h"
+#include "mime_types.h"
+#include <cstring>
+
+namespace webdav {
+
+namespace {
+
+const char DAY_NAMES[7][4] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+const char MONTH_NAMES[12][4] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                 "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+// 每个资源都相同的属性片段
+const char SUPPORTED_LOCK[] =
+    "        <D:supportedlock>\n"
+    "          <D:lockentry>\n"
+    "            <D:lockscope><D:exclusive/></D:lockscope>\n"
+    "            <D:locktype><D:write/></D:locktype>\n"
+    "          </D:lockentry>\n"
+    "        </D:supportedlock>\n";
+
+struct CivilTime {
+    int year;
+    unsigned month;   // 1-12
+    unsigned day;     // 1-31
+    unsigned weekday; // 0 = Sunday
+    unsigned hour;
+    unsigned minute;
+    unsigned second;
+};
+
+// 不经过 gmtime_r 的 UTC 日期换算（Howard Hinnant 的 civil_from_days 算法）
+CivilTime to_civil(time_t t) {
+    int64_t seconds = static_cast<int64_t>(t);
+    int64_t days = seconds / 86400;
+    int64_t rem = seconds % 86400;
+    if (rem < 0) {
+        rem += 86400;
+        --days;
+    }
+
+    CivilTime ct;
+    ct.hour = static_cast<unsigned>(rem / 3600);
+    ct.minute = static_cast<unsigned>(rem % 3600 / 60);
+    ct.second = static_cast<unsigned>(rem % 60);
+    int64_t weekday = (days + 4) % 7;  // 1970-01-01 是星期四
+    ct.weekday = static_cast<unsigned>(weekday < 0 ? weekday + 7 : weekday);
+
+    int64_t z = days + 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = static_cast<unsigned>(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    ct.day = doy - (153 * mp + 2) / 5 + 1;
+    ct.month = mp < 10 ? mp + 3 : mp - 9;
+    ct.year = static_cast<int>(yoe + era * 400 + (ct.month <= 2 ? 1 : 0));
+    return ct;
+}
+
+// 写入定宽的十进制数字
+char* put_digits(char* out, unsigned value, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return out + width;
+}
+
+bool is_unreserved(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '-' || c == '_' || c == '.' || c == '~' || c == '/';
+}
+
+} // namespace
+
+MultistatusWriter::MultistatusWriter(size_t reserve) {
+    buffer_.reserve(reserve);
+}
+
+void MultistatusWriter::begin() {
+    append_literal("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+                   "<D:multistatus xmlns:D=\"DAV:\">\n");
+}
+
+void MultistatusWriter::end() {
+    append_literal("</D:multistatus>");
+}
+
+void MultistatusWriter::add_response(const std::string& base_href, const std::string& path_suffix,
+                                     const FileInfo& info, const PropfindRequest& request) {
+    append_literal("  <D:response>\n"
+                   "    <D:href>");
+    append_escaped(base_href);
+    append_path_encoded(path_suffix);
+    append_literal("</D:href>\n");
+
+    if (request.mode != PropfindRequest::PROP) {
+        bool names_only = request.mode == PropfindRequest::PROP_NAME;
+        append_literal("    <D:propstat>\n"
+                       "      <D:prop>\n");
+        append_live_props(info, PROP_ALL_LIVE, names_only);
+        for (const auto& prop : info.properties) {
+            append_dead_property(prop.first, names_only ? nullptr : &prop.second);
+        }
+        append_propstat_end("HTTP/1.1 200 OK");
+        append_literal("  </D:response>\n");
+        return;
+    }
+
+    // 先判断点名的死属性是否存在，找到的和活属性一起放进 200 的 propstat
+    size_t missing = 0;
+    bool any_found = request.live_props != 0;
+    for (const auto& prop : request.other_props) {
+        if (info.properties.count(clark_name(prop.first, prop.second))) {
+            any_found = true;
+        } else {
+            ++missing;
+        }
+    }
+
+    if (any_found) {
+        append_literal("    <D:propstat>\n"
+                       "      <D:prop>\n");
+        append_live_props(info, request.live_props, false);
+        for (const auto& prop : request.other_props) {
+            auto it = info.properties.find(clark_name(prop.first, prop.second));
+            if (it != info.properties.end()) {
+                append_property(prop.first, prop.second, &it->second);
+            }
+        }
+        append_propstat_end("HTTP/1.1 200 OK");
+    }
+
+    if (missing > 0) {
+        append_literal("    <D:propstat>\n"
+                       "      <D:prop>\n");
+        for (const auto& prop : request.other_props) {
+            if (!info.properties.count(clark_name(prop.first, prop.second))) {
+                append_property(prop.first, prop.second, nullptr);
+            }
+        }
+        append_propstat_end("HTTP/1.1 404 Not Found");
+    }
+    append_literal("  </D:response>\n");
+}
+
+void MultistatusWriter::begin_response(const std::string& href) {
+    append_literal("  <D:response>\n"
+                   "    <D:href>");
+    append_escaped(href);
+    append_literal("</D:href>\n");
+}
+
+void MultistatusWriter::add_propstat(const std::vector<std::pair<std::string, std::string>>& names,
+                                     const char* status_line) {
+    append_literal("    <D:propstat>\n"
+                   "      <D:prop>\n");
+    for (const auto& name : names) {
+        append_property(name.first, name.second, nullptr);
+    }
+    append_propstat_end(status_line);
+}
+
+void MultistatusWriter::end_response() {
+    append_literal("  </D:response>\n");
+}
+
+void MultistatusWriter::append_live_props(const FileInfo& info, unsigned props, bool names_only) {
+    if (names_only) {
+        append_literal("        <D:resourcetype/>\n"
+                       "        <D:getcontentlength/>\n"
+                       "        <D:getlastmodified/>\n"
+                       "        <D:creationdate/>\n"
+                       "        <D:getetag/>\n"
+                       "        <D:getcontenttype/>\n"
+                       "        <D:displayname/>\n"
+                       "        <D:supportedlock/>\n");
+        return;
+    }
+
+    if (props & PROP_RESOURCETYPE) {
+        if (info.is_directory) {
+            append_literal("        <D:resourcetype><D:collection/></D:resourcetype>\n");
+        } else {
+            append_literal("        <D:resourcetype></D:resourcetype>\n");
+        }
+    }
+    if (props & PROP_GETCONTENTLENGTH) {
+        append_literal("        <D:getcontentlength>");
+        append_uint(info.size);
+        append_literal("</D:getcontentlength>\n");
+    }
+    if (props & PROP_GETLASTMODIFIED) {
+        append_literal("        <D:getlastmodified>");
+        append_http_date(info.modified_time);
+        append_literal("</D:getlastmodified>\n");
+    }
+    if (props & PROP_CREATIONDATE) {
+        append_literal("        <D:creationdate>");
+        append_iso_date(info.created_time);
+        append_literal("</D:creationdate>\n");
+    }
+    if (props & PROP_GETETAG) {
+        append_literal("        <D:getetag>");
+        append_escaped(info.etag);
+        append_literal("</D:getetag>\n");
+    }
+    if (props & PROP_GETCONTENTTYPE) {
+        append_literal("        <D:getcontenttype>");
+        buffer_ += MimeTypes::lookup(info.name);
+        append_literal("</D:getcontenttype>\n");
+    }
+    if (props & PROP_DISPLAYNAME) {
+        append_literal("        <D:displayname>");
+        append_escaped(info.name);
+        append_literal("</D:displayname>\n");
+    }
+    if (props & PROP_SUPPORTEDLOCK) {
+        append_literal(SUPPORTED_LOCK);
+    }
+}
+
+void MultistatusWriter::append_property(const std::string& ns, const std::string& local,
+                                        const std::string* value) {
+    bool dav = ns == "DAV:";
+    append_literal("        <");
+    if (dav) {
+        append_literal("D:");
+    }
+    buffer_ += local;
+    if (!dav) {
+        append_literal(" xmlns=\"");
+        append_escaped(ns, true);
+        buffer_ += '"';
+    }
+    if (!value) {
+        append_literal("/>\n");
+        return;
+    }
+    buffer_ += '>';
+    append_escaped(*value);
+    append_literal("</");
+    if (dav) {
+        append_literal("D:");
+    }
+    buffer_ += local;
+    append_literal(">\n");
+}
+
+void MultistatusWriter::append_dead_property(const std::string& key, const std::string* value) {
+    size_t close = key.find('}');
+    if (!key.empty() && key[0] == '{' && close != std::string::npos) {
+        append_property(key.substr(1, close - 1), key.substr(close + 1), value);
+        return;
+    }
+
+    // 非 Clark 记法的键按原样作为元素名
+    append_literal("        <");
+    buffer_ += key;
+    if (!value) {
+        append_literal("/>\n");
+        return;
+    }
+    buffer_ += '>';
+    append_escaped(*value);
+    append_literal("</");
+    buffer_ += key;
+    append_literal(">\n");
+}
+
+void MultistatusWriter::append_propstat_end(const char* status_line) {
+    append_literal("      </D:prop>\n"
+                   "      <D:status>");
+    buffer_ += status_line;
+    append_literal("</D:status>\n"
+                   "    </D:propstat>\n");
+}
+
+void MultistatusWriter::add_status(const std::string& href, const char* status_line,
+                                   const char* error_element) {
+    append_literal("  <D:response>\n"
+                   "    <D:href>");
+    append_escaped(href);
+    append_literal("</D:href>\n"
+                   "    <D:status>");
+    buffer_ += status_line;
+    append_literal("</D:status>\n");
+    if (error_element) {
+        append_literal("    <D:error><");
+        buffer_ += error_element;
+        append_literal("/></D:error>\n");
+    }
+    append_literal("  </D:response>\n");
+}
+
+void MultistatusWriter::add_member_status(const std::string& base_href, const std::string& path_suffix,
+                                          const char* status_line) {
+    append_literal("  <D:response>\n"
+                   "    <D:href>");
+    append_escaped(base_href);
+    append_path_encoded(path_suffix);
+    append_literal("</D:href>\n"
+                   "    <D:status>");
+    buffer_ += status_line;
+    append_literal("</D:status>\n"
+                   "  </D:response>\n");
+}
+
+void MultistatusWriter::append_escaped(const std::string& text, bool attribute) {
+    // 没有需要转义的字符时整段追加
+    size_t start = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        const char* entity;
+        size_t length;
+        switch (text[i]) {
+        case '&': entity = "&amp;"; length = 5; break;
+        case '<': entity = "&lt;"; length = 4; break;
+        case '>': entity = "&gt;"; length = 4; break;
+        case '"':
+            if (!attribute) continue;
+            entity = "&quot;"; length = 6; break;
+        default: continue;
+        }
+        buffer_.append(text, start, i - start);
+        buffer_.append(entity, length);
+        start = i + 1;
+    }
+    buffer_.append(text, start, std::string::npos);
+}
+
+void MultistatusWriter::append_path_encoded(const std::string& path) {
+    // 百分号编码后只剩非保留字符，不再需要 XML 转义
+    for (size_t i = 0; i < path.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(path[i]);
+        if (is_unreserved(c)) {
+            buffer_ += static_cast<char>(c);
+        } else {
+            char encoded[3] = {'%', HEX_DIGITS[c >> 4], HEX_DIGITS[c & 0x0F]};
+            buffer_.append(encoded, 3);
+        }
+    }
+}
+
+void MultistatusWriter::append_uint(uint64_t value) {
+    char digits[20];
+    char* p = digits + sizeof(digits);
+    do {
+        *--p = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    buffer_.append(p, digits + sizeof(digits) - p);
+}
+
+void MultistatusWriter::append_http_date(time_t t) {
+    // "Sun, 06 Nov 1994 08:49:37 GMT"
+    CivilTime ct = to_civil(t);
+    char out[29];
+    char* p = out;
+    memcpy(p, DAY_NAMES[ct.weekday], 3);
+    p += 3;
+    *p++ = ',';
+    *p++ = ' ';
+    p = put_digits(p, ct.day, 2);
+    *p++ = ' ';
+    memcpy(p, MONTH_NAMES[ct.month - 1], 3);
+    p += 3;
+    *p++ = ' ';
+    p = put_digits(p, static_cast<unsigned>(ct.year), 4);
+    *p++ = ' ';
+    p = put_digits(p, ct.hour, 2);
+    *p++ = ':';
+    p = put_digits(p, ct.minute, 2);
+    *p++ = ':';
+    p = put_digits(p, ct.second, 2);
+    memcpy(p, " GMT", 4);
+    buffer_.append(out, sizeof(out));
+}
+
+void MultistatusWriter::append_iso_date(time_t t) {
+    // "1994-11-06T08:49:37Z"
+    CivilTime ct = to_civil(t);
+    char out[20];
+    char* p = put_digits(out, static_cast<unsigned>(ct.year), 4);
+    *p++ = '-';
+    p = put_digits(p, ct.month, 2);
+    *p++ = '-';
+    p = put_digits(p, ct.day, 2);
+    *p++ = 'T';
+    p = put_digits(p, ct.hour, 2);
+    *p++ = ':';
+    p = put_digits(p, ct.minute, 2);
+    *p++ = ':';
+    p = put_digits(p, ct.second, 2);
+    *p = 'Z';
+    buffer_.append(out, sizeof(out));
+}
+
+} // namespace webdav
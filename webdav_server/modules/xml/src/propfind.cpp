@@ -0,0 +1,81 @@
+#include "propfind.h"
+#include <cstring>
+
+namespace webdav {
+
+namespace {
+
+const struct {
+    const char* name;
+    LiveProperty bit;
+} LIVE_PROPERTIES[] = {
+    {"resourcetype", PROP_RESOURCETYPE},
+    {"getcontentlength", PROP_GETCONTENTLENGTH},
+    {"getlastmodified", PROP_GETLASTMODIFIED},
+    {"creationdate", PROP_CREATIONDATE},
+    {"getetag", PROP_GETETAG},
+    {"getcontenttype", PROP_GETCONTENTTYPE},
+    {"displayname", PROP_DISPLAYNAME},
+    {"supportedlock", PROP_SUPPORTEDLOCK},
+};
+
+bool is_dav(const std::shared_ptr<XMLNode>& node, const char* local) {
+    return node->namespace_uri == "DAV:" && node->local_name == local;
+}
+
+} // namespace
+
+bool build_propfind_request(const std::shared_ptr<XMLNode>& root, PropfindRequest& request) {
+    if (!root || !is_dav(root, "propfind")) {
+        return false;
+    }
+
+    request = PropfindRequest();
+    for (const auto& child : root->children) {
+        if (is_dav(child, "allprop")) {
+            // <include> 里的属性 allprop 已经全部包含
+            request.mode = PropfindRequest::ALL_PROP;
+            return true;
+        }
+        if (is_dav(child, "propname")) {
+            request.mode = PropfindRequest::PROP_NAME;
+            return true;
+        }
+        if (!is_dav(child, "prop")) {
+            continue;
+        }
+
+        request.mode = PropfindRequest::PROP;
+        request.live_props = 0;
+        for (const auto& prop : child->children) {
+            unsigned bit = live_property_bit(prop->namespace_uri, prop->local_name);
+            if (bit) {
+                request.live_props |= bit;
+            } else {
+                request.other_props.emplace_back(prop->namespace_uri, prop->local_name);
+            }
+        }
+        return true;
+    }
+
+    // 缺少 allprop、propname 和 prop 的请求体无效
+    return false;
+}
+
+unsigned live_property_bit(const std::string& ns, const std::string& local) {
+    if (ns != "DAV:") {
+        return 0;
+    }
+    for (const auto& live : LIVE_PROPERTIES) {
+        if (local == live.name) {
+            return live.bit;
+        }
+    }
+    return 0;
+}
+
+std::string clark_name(const std::string& ns, const std::string& local) {
+    return "{" + ns + "}" + local;
+}
+
+} // namespace webdav
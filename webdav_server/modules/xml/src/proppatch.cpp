@@ -0,0 +1,36 @@
+#include "proppatch.h"
+
+namespace webdav {
+
+bool build_proppatch_request(const std::shared_ptr<XMLNode>& root, std::vector<PropertyOperation>& operations) {
+    if (!root || root->namespace_uri != "DAV:" || root->local_name != "propertyupdate") {
+        return false;
+    }
+
+    operations.clear();
+    for (const auto& action : root->children) {
+        if (action->namespace_uri != "DAV:" ||
+            (action->local_name != "set" && action->local_name != "remove")) {
+            continue;
+        }
+        bool remove = action->local_name == "remove";
+        for (const auto& prop : action->children) {
+            if (prop->namespace_uri != "DAV:" || prop->local_name != "prop") {
+                continue;
+            }
+            for (const auto& item : prop->children) {
+                PropertyOperation operation;
+                operation.remove = remove;
+                operation.ns = item->namespace_uri;
+                operation.local_name = item->local_name;
+                if (!remove) {
+                    operation.value = item->value;
+                }
+                operations.push_back(operation);
+            }
+        }
+    }
+    return !operations.empty();
+}
+
+} // namespace webdav
@@ -1,6 +1,9 @@
 #include "xml_parser.h"
 #include <sstream>
 #include <stack>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
 
 namespace webdav {
 
@@ -8,15 +11,116 @@ XMLParser::XMLParser() {}
 
 XMLParser::~XMLParser() {}
 
+namespace {
+
+// 解码预定义实体和数字字符引用，无法识别的实体原样保留
+void append_decoded(std::string& out, const std::string& xml, size_t begin, size_t end) {
+    static const struct { const char* name; char ch; } ENTITIES[] = {
+        {"amp;", '&'}, {"lt;", '<'}, {"gt;", '>'}, {"quot;", '"'}, {"apos;", '\''}
+    };
+    
+    for (size_t i = begin; i < end; ++i) {
+        if (xml[i] != '&') {
+            out += xml[i];
+            continue;
+        }
+        
+        size_t semicolon = xml.find(';', i);
+        if (semicolon == std::string::npos || semicolon >= end) {
+            out += xml[i];
+            continue;
+        }
+        
+        bool decoded = false;
+        if (xml[i + 1] == '#') {
+            bool hex = i + 2 < semicolon && (xml[i + 2] == 'x' || xml[i + 2] == 'X');
+            std::string digits = xml.substr(i + (hex ? 3 : 2), semicolon - i - (hex ? 3 : 2));
+            char* parse_end = nullptr;
+            unsigned long code = digits.empty() ? 0 : strtoul(digits.c_str(), &parse_end, hex ? 16 : 10);
+            if (code > 0 && code <= 0x10FFFF && parse_end && *parse_end == '\0') {
+                // 以 UTF-8 编码输出
+                if (code < 0x80) {
+                    out += static_cast<char>(code);
+                } else if (code < 0x800) {
+                    out += static_cast<char>(0xC0 | (code >> 6));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                } else if (code < 0x10000) {
+                    out += static_cast<char>(0xE0 | (code >> 12));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                } else {
+                    out += static_cast<char>(0xF0 | (code >> 18));
+                    out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                decoded = true;
+            }
+        } else {
+            for (const auto& entity : ENTITIES) {
+                if (xml.compare(i + 1, strlen(entity.name), entity.name) == 0) {
+                    out += entity.ch;
+                    decoded = true;
+                    break;
+                }
+            }
+        }
+        
+        if (decoded) {
+            i = semicolon;
+        } else {
+            out += xml[i];
+        }
+    }
+}
+
+bool starts_with(const std::string& xml, size_t pos, const char* prefix) {
+    return xml.compare(pos, strlen(prefix), prefix) == 0;
+}
+
+} // namespace
+
 bool XMLParser::parse(const std::string& xml, std::shared_ptr<XMLNode>& root) {
     size_t pos = 0;
     root = std::make_shared<XMLNode>();
-    return parse_node(xml, pos, root);
+    
+    // 根元素之前可以有 XML 声明、注释、处理指令和 DOCTYPE
+    while (true) {
+        while (pos < xml.length() && std::isspace(static_cast<unsigned char>(xml[pos]))) pos++;
+        if (!skip_markup(xml, pos)) break;
+    }
+    
+    if (!parse_node(xml, pos, root)) return false;
+    resolve_namespaces(root, std::map<std::string, std::string>());
+    return true;
+}
+
+bool XMLParser::skip_markup(const std::string& xml, size_t& pos) {
+    size_t end;
+    if (starts_with(xml, pos, "<!--")) {
+        end = xml.find("-->", pos + 4);
+        if (end == std::string::npos) return false;
+        pos = end + 3;
+        return true;
+    }
+    if (starts_with(xml, pos, "<?")) {
+        end = xml.find("?>", pos + 2);
+        if (end == std::string::npos) return false;
+        pos = end + 2;
+        return true;
+    }
+    if (starts_with(xml, pos, "<!") && !starts_with(xml, pos, "<![CDATA[")) {
+        end = xml.find('>', pos + 2);
+        if (end == std::string::npos) return false;
+        pos = end + 1;
+        return true;
+    }
+    return false;
 }
 
 bool XMLParser::parse_node(const std::string& xml, size_t& pos, std::shared_ptr<XMLNode>& node) {
     // 跳过空白字符
-    while (pos < xml.length() && std::isspace(xml[pos])) pos++;
+    while (pos < xml.length() && std::isspace(static_cast<unsigned char>(xml[pos]))) pos++;
     
     if (pos >= xml.length() || xml[pos] != '<') return false;
     pos++; // 跳过 '<'
@@ -29,8 +133,9 @@ bool XMLParser::parse_node(const std::string& xml, size_t& pos, std::shared_ptr<
     if (!parse_attributes(xml, pos, node->attributes)) return false;
     
     // 检查是否是自闭合标签
-    while (pos < xml.length() && std::isspace(xml[pos])) pos++;
+    while (pos < xml.length() && std::isspace(static_cast<unsigned char>(xml[pos]))) pos++;
     if (pos < xml.length() && xml[pos] == '/') {
+        if (pos + 1 >= xml.length() || xml[pos + 1] != '>') return false;
         pos += 2; // 跳过 "/>"
         return true;
     }
@@ -38,34 +143,44 @@ bool XMLParser::parse_node(const std::string& xml, size_t& pos, std::shared_ptr<
     if (pos >= xml.length() || xml[pos] != '>') return false;
     pos++; // 跳过 '>'
     
-    // 解析子节点和文本内容
+    // 解析子节点和文本内容，文本中的空白原样保留，结束时再去掉首尾空白
     std::string content;
     while (pos < xml.length()) {
-        while (pos < xml.length() && std::isspace(xml[pos])) pos++;
-        if (pos >= xml.length()) break;
+        if (xml[pos] != '<') {
+            size_t text_end = xml.find('<', pos);
+            if (text_end == std::string::npos) return false;
+            append_decoded(content, xml, pos, text_end);
+            pos = text_end;
+            continue;
+        }
         
-        if (xml[pos] == '<') {
-            if (xml[pos + 1] == '/') { // 结束标签
-                pos += 2;
-                std::string end_tag = get_tag_name(xml, pos);
-                if (end_tag != node->name) return false;
-                
-                while (pos < xml.length() && xml[pos] != '>') pos++;
-                if (pos >= xml.length()) return false;
-                pos++;
-                
-                if (!content.empty()) {
-                    node->value = content;
-                }
-                return true;
-            } else { // 子节点
-                auto child = std::make_shared<XMLNode>();
-                child->parent = node;
-                if (!parse_node(xml, pos, child)) return false;
-                node->children.push_back(child);
+        if (starts_with(xml, pos, "<![CDATA[")) {
+            size_t end = xml.find("]]>", pos + 9);
+            if (end == std::string::npos) return false;
+            content.append(xml, pos + 9, end - pos - 9);
+            pos = end + 3;
+        } else if (skip_markup(xml, pos)) {
+            continue;
+        } else if (starts_with(xml, pos, "</")) { // 结束标签
+            pos += 2;
+            std::string end_tag = get_tag_name(xml, pos);
+            if (end_tag != node->name) return false;
+            
+            while (pos < xml.length() && xml[pos] != '>') pos++;
+            if (pos >= xml.length()) return false;
+            pos++;
+            
+            size_t first = content.find_first_not_of(" \t\r\n");
+            if (first != std::string::npos) {
+                size_t last = content.find_last_not_of(" \t\r\n");
+                node->value = content.substr(first, last - first + 1);
             }
-        } else {
-            content += xml[pos++];
+            return true;
+        } else { // 子节点
+            auto child = std::make_shared<XMLNode>();
+            child->parent = node;
+            if (!parse_node(xml, pos, child)) return false;
+            node->children.push_back(child);
         }
     }
     
@@ -75,31 +190,33 @@ bool XMLParser::parse_node(const std::string& xml, size_t& pos, std::shared_ptr<
 bool XMLParser::parse_attributes(const std::string& xml, size_t& pos, 
                                std::map<std::string, std::string>& attributes) {
     while (pos < xml.length()) {
-        while (pos < xml.length() && std::isspace(xml[pos])) pos++;
+        while (pos < xml.length() && std::isspace(static_cast<unsigned char>(xml[pos]))) pos++;
         if (pos >= xml.length()) return false;
         
         if (xml[pos] == '>' || xml[pos] == '/') return true;
         
         std::string name;
-        while (pos < xml.length() && !std::isspace(xml[pos]) && xml[pos] != '=') {
+        while (pos < xml.length() && !std::isspace(static_cast<unsigned char>(xml[pos])) &&
+               xml[pos] != '=' && xml[pos] != '>' && xml[pos] != '/') {
             name += xml[pos++];
         }
+        if (name.empty()) return false;
         
-        while (pos < xml.length() && std::isspace(xml[pos])) pos++;
+        while (pos < xml.length() && std::isspace(static_cast<unsigned char>(xml[pos]))) pos++;
         if (pos >= xml.length() || xml[pos] != '=') return false;
         pos++;
         
-        while (pos < xml.length() && std::isspace(xml[pos])) pos++;
-        if (pos >= xml.length() || xml[pos] != '"') return false;
-        pos++;
+        // 属性值可以用双引号或单引号
+        while (pos < xml.length() && std::isspace(static_cast<unsigned char>(xml[pos]))) pos++;
+        if (pos >= xml.length() || (xml[pos] != '"' && xml[pos] != '\'')) return false;
+        char quote = xml[pos++];
         
-        std::string value;
-        while (pos < xml.length() && xml[pos] != '"') {
-            value += xml[pos++];
-        }
+        size_t end = xml.find(quote, pos);
+        if (end == std::string::npos) return false;
         
-        if (pos >= xml.length()) return false;
-        pos++; // 跳过结束引号
+        std::string value;
+        append_decoded(value, xml, pos, end);
+        pos = end + 1; // 跳过结束引号
         
         attributes[name] = value;
     }
@@ -109,13 +226,35 @@ bool XMLParser::parse_attributes(const std::string& xml, size_t& pos,
 
 std::string XMLParser::get_tag_name(const std::string& xml, size_t& pos) {
     std::string name;
-    while (pos < xml.length() && !std::isspace(xml[pos]) && 
+    while (pos < xml.length() && !std::isspace(static_cast<unsigned char>(xml[pos])) && 
            xml[pos] != '>' && xml[pos] != '/') {
         name += xml[pos++];
     }
     return name;
 }
 
+void XMLParser::resolve_namespaces(const std::shared_ptr<XMLNode>& node,
+                                   std::map<std::string, std::string> scope) {
+    // 本元素上的 xmlns 声明对自身和子元素生效，空前缀表示默认命名空间
+    for (const auto& attr : node->attributes) {
+        if (attr.first == "xmlns") {
+            scope[""] = attr.second;
+        } else if (attr.first.compare(0, 6, "xmlns:") == 0) {
+            scope[attr.first.substr(6)] = attr.second;
+        }
+    }
+    
+    size_t colon = node->name.find(':');
+    std::string prefix = colon == std::string::npos ? std::string() : node->name.substr(0, colon);
+    node->local_name = colon == std::string::npos ? node->name : node->name.substr(colon + 1);
+    auto it = scope.find(prefix);
+    node->namespace_uri = it != scope.end() ? it->second : std::string();
+    
+    for (const auto& child : node->children) {
+        resolve_namespaces(child, scope);
+    }
+}
+
 std::string XMLParser::build(const std::shared_ptr<XMLNode>& root) {
     std::stringstream ss;
     
@@ -23,6 +23,17 @@ void print_usage() {
               << "  --host HOST     Server host address (default: 0.0.0.0)\n"
               << "  --port PORT     Server port (default: 8080)\n"
               << "  --root PATH     Root directory path (default: ./webdav_root)\n"
+              << "  --workers N     Worker threads (default: number of CPU cores)\n"
+              << "  --queue N       Max queued requests before replying 503 (default: 1024)\n"
+              << "  --listeners N   SO_REUSEPORT listeners, one event loop per core (default: 1, 0 = per core)\n"
+              << "  --propfind-max-depth N    Levels walked for Depth: infinity (default: 64)\n"
+              << "  --propfind-max-entries N  Entries per PROPFIND before truncating with 507 (default: 100000)\n"
+              << "  --no-propfind-infinity    Reject Depth: infinity PROPFIND with 403\n"
+              << "  --property-store PATH     Dead property log file (default: webdav_props.db)\n"
+              << "  --metadata-cache-mb N     Memory budget of the metadata cache (default: 64)\n"
+              << "  --traversal-threads N     Helper threads for directory tree walks (default: 4, 0 = none)\n"
+              << "  --durability MODE         fsync per file, group (batched syncfs) or none (default: fsync)\n"
+              << "  --group-commit-us N       Extra wait for batching syncs in group mode (default: 0)"
               << std::endl;
 }
 
@@ -45,6 +56,7 @@ int main(int argc, char* argv[]) {
     std::string host = "0.0.0.0";
     int port = 8080;
     std::string root_path = "./webdav_root";
+    ServerConfig config;
     
     // 解析命令行参数
     for (int i = 1; i < argc; i++) {
@@ -58,6 +70,39 @@ int main(int argc, char* argv[]) {
             port = std::stoi(argv[++i]);
         } else if (arg == "--root" && i + 1 < argc) {
             root_path = argv[++i];
+        } else if (arg == "--workers" && i + 1 < argc) {
+            config.worker_threads = std::stoul(argv[++i]);
+        } else if (arg == "--queue" && i + 1 < argc) {
+            config.max_queued_requests = std::stoul(argv[++i]);
+        } else if (arg == "--listeners" && i + 1 < argc) {
+            config.listeners = std::stoul(argv[++i]);
+        } else if (arg == "--propfind-max-depth" && i + 1 < argc) {
+            config.propfind_max_depth = std::stoi(argv[++i]);
+        } else if (arg == "--propfind-max-entries" && i + 1 < argc) {
+            config.propfind_max_entries = std::stoul(argv[++i]);
+        } else if (arg == "--no-propfind-infinity") {
+            config.propfind_infinity = false;
+        } else if (arg == "--property-store" && i + 1 < argc) {
+            config.property_store = argv[++i];
+        } else if (arg == "--metadata-cache-mb" && i + 1 < argc) {
+            config.metadata_cache_bytes = std::stoul(argv[++i]) * 1024 * 1024;
+        } else if (arg == "--traversal-threads" && i + 1 < argc) {
+            config.traversal_threads = std::stoul(argv[++i]);
+        } else if (arg == "--durability" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode == "fsync") {
+                config.durability = DurabilityMode::FSYNC;
+            } else if (mode == "group") {
+                config.durability = DurabilityMode::GROUP_COMMIT;
+            } else if (mode == "none") {
+                config.durability = DurabilityMode::NONE;
+            } else {
+                std::cerr << "Unknown durability mode: " << mode << std::endl;
+                print_usage();
+                return 1;
+            }
+        } else if (arg == "--group-commit-us" && i + 1 < argc) {
+            config.group_commit_us = std::stoul(argv[++i]);
         } else {
             std::cerr << "Unknown option: " << arg << std::endl;
             print_usage();
@@ -67,7 +112,7 @@ int main(int argc, char* argv[]) {
     
     try {
         // 创建并启动服务器
-        server = new WebDAVServer(host, port, root_path);
+        server = new WebDAVServer(host, port, root_path, config);
         
         if (!server->start()) {
             std::cerr << "Failed to start server" << std::endl;
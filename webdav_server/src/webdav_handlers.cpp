@@ -1,13 +1,129 @@
 #include "webdav_server.h"
 #include "mime_types.h"
+#include "multistatus_writer.h"
+#include "propfind.h"
+#include "proppatch.h"
+#include "byte_range.h"
 #include <sstream>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <string.h>
+#include <strings.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
 
 namespace webdav {
 
+namespace {
+
+const size_t PUT_BUFFER_SIZE = 256 * 1024;  // PUT 每次接收并写盘的块大小
+const size_t MULTISTATUS_FLUSH_SIZE = 64 * 1024;  // 多状态响应每攒够这么多就交给连接层发送
+
+std::string make_boundary() {
+    static std::atomic<unsigned long> counter(0);
+    char buf[64];
+    snprintf(buf, sizeof(buf), "webdav_byteranges_%lx_%lx",
+             static_cast<unsigned long>(time(nullptr)), ++counter);
+    return buf;
+}
+
+struct ErrorStatus {
+    int code;
+    const char* message;
+    const char* status_line;
+};
+
+// 文件操作失败的 errno 对应的 HTTP 状态
+ErrorStatus error_status(int error) {
+    switch (error) {
+    case ENOENT:
+    case ENOTDIR:
+        return ErrorStatus{404, "Not Found", "HTTP/1.1 404 Not Found"};
+    case EACCES:
+    case EPERM:
+    case EROFS:
+        return ErrorStatus{403, "Forbidden", "HTTP/1.1 403 Forbidden"};
+    case ENOSPC:
+    case EDQUOT:
+        return ErrorStatus{507, "Insufficient Storage", "HTTP/1.1 507 Insufficient Storage"};
+    default:
+        return ErrorStatus{500, "Internal Server Error", "HTTP/1.1 500 Internal Server Error"};
+    }
+}
+
+// 目录树操作部分失败时按 RFC 4918 返回 207，每个失败的成员一条状态；
+// base_href 为已编码的请求（或目标）路径，base_path 为其解码后的形式
+void set_failure_multistatus(const std::string& base_href, const std::string& base_path,
+                             const std::vector<FileManager::TreeFailure>& failures, HTTPResponse& response) {
+    std::string href = base_href;
+    std::string prefix = base_path;
+    while (!href.empty() && href.back() == '/') href.pop_back();
+    while (!prefix.empty() && prefix.back() == '/') prefix.pop_back();
+    
+    MultistatusWriter writer;
+    writer.begin();
+    for (const auto& failure : failures) {
+        std::string suffix = failure.path.compare(0, prefix.size(), prefix) == 0 ?
+                             failure.path.substr(prefix.size()) : failure.path;
+        writer.add_member_status(href, suffix, error_status(failure.error).status_line);
+    }
+    writer.end();
+    
+    response.status_code = 207;
+    response.status_message = "Multi-Status";
+    response.headers["Content-Type"] = "application/xml; charset=utf-8";
+    response.body.assign(writer.data(), writer.data() + writer.size());
+}
+
+// Destination 头可以是绝对 URL 或绝对路径，返回其中未解码的路径部分，无法识别时返回空串
+std::string destination_uri_path(const std::string& url) {
+    size_t scheme = url.find("://");
+    if (scheme == std::string::npos) {
+        return !url.empty() && url[0] == '/' ? url : std::string();
+    }
+    size_t path_start = url.find('/', scheme + 3);
+    return path_start == std::string::npos ? std::string() : url.substr(path_start);
+}
+
+// 从 Prefer 头中取出分页偏好 "page-size=N" 和 "page-token=T"（值可加引号），其余偏好忽略
+void parse_paging_preference(const std::string& value, size_t& page_size, std::string& page_token) {
+    size_t pos = 0;
+    while (pos < value.size()) {
+        size_t end = value.find_first_of(",;", pos);
+        if (end == std::string::npos) {
+            end = value.size();
+        }
+        std::string item = value.substr(pos, end - pos);
+        pos = end + 1;
+        
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            continue;
+        }
+        std::string name = item.substr(0, eq);
+        std::string arg = item.substr(eq + 1);
+        name.erase(0, name.find_first_not_of(" \t"));
+        name.erase(name.find_last_not_of(" \t") + 1);
+        arg.erase(0, arg.find_first_not_of(" \t"));
+        arg.erase(arg.find_last_not_of(" \t") + 1);
+        if (arg.size() >= 2 && arg.front() == '"' && arg.back() == '"') {
+            arg = arg.substr(1, arg.size() - 2);
+        }
+        
+        if (strcasecmp(name.c_str(), "page-size") == 0) {
+            parse_size(arg, page_size);
+        } else if (strcasecmp(name.c_str(), "page-token") == 0) {
+            page_token = arg;
+        }
+    }
+}
+
+} // namespace
+
 void WebDAVServer::handle_options(const HTTPRequest& request, HTTPResponse& response) {
     (void)request; // 未使用的参数
     
@@ -46,107 +162,178 @@ void WebDAVServer::handle_get(const HTTPRequest& request, HTTPResponse& response
         return;
     }
     
-    std::vector<char> data;
-    if (!file_manager_->read_file(path, data)) {
+    // 文件内容不读入内存，由发送端用 sendfile 直接从 fd 发出
+    int fd = -1;
+    size_t size = 0;
+    if (!file_manager_->open_file(path, fd, size)) {
         response.status_code = 500;
         response.status_message = "Internal Server Error";
         return;
     }
     
-    response.status_code = 200;
-    response.status_message = "OK";
-    response.headers["Content-Type"] = MimeTypes::get_mime_type(path);
-    response.headers["Content-Length"] = std::to_string(data.size());
+    std::string content_type = MimeTypes::get_mime_type(path);
+    std::string last_modified = format_http_date(info.modified_time);
     response.headers["ETag"] = info.etag;
-    response.headers["Last-Modified"] = std::to_string(info.modified_time);
-    response.body = std::move(data);
+    response.headers["Last-Modified"] = last_modified;
+    response.headers["Accept-Ranges"] = "bytes";
+    
+    // If-Range 与当前版本不符时忽略 Range，返回整个文件
+    std::vector<ByteRange> ranges;
+    RangeResult range_result = RangeResult::IGNORE;
+    auto range_header = request.headers.find("Range");
+    auto if_range = request.headers.find("If-Range");
+    if (range_header != request.headers.end() &&
+        (if_range == request.headers.end() ||
+         if_range->second == info.etag || if_range->second == last_modified)) {
+        range_result = parse_range_header(range_header->second, size, ranges);
+    }
+    
+    if (range_result == RangeResult::UNSATISFIABLE) {
+        close(fd);
+        response.status_code = 416;
+        response.status_message = "Range Not Satisfiable";
+        response.headers["Content-Range"] = "bytes */" + std::to_string(size);
+        response.headers["Content-Length"] = "0";
+        return;
+    }
+    
+    response.file_fd = fd;
+    
+    if (range_result == RangeResult::IGNORE) {
+        response.status_code = 200;
+        response.status_message = "OK";
+        response.headers["Content-Type"] = content_type;
+        response.file_segments.push_back(FileSegment(0, size));
+    } else if (ranges.size() == 1) {
+        response.status_code = 206;
+        response.status_message = "Partial Content";
+        response.headers["Content-Type"] = content_type;
+        response.headers["Content-Range"] = content_range(ranges[0], size);
+        response.file_segments.push_back(
+            FileSegment(ranges[0].first, ranges[0].second - ranges[0].first + 1));
+    } else {
+        // 多个范围：multipart/byteranges，每段的分段头放在对应文件数据之前
+        std::string boundary = make_boundary();
+        response.status_code = 206;
+        response.status_message = "Partial Content";
+        response.headers["Content-Type"] = "multipart/byteranges; boundary=" + boundary;
+        for (const auto& range : ranges) {
+            std::string part_header = "\r\n--" + boundary + "\r\n"
+                                      "Content-Type: " + content_type + "\r\n"
+                                      "Content-Range: " + content_range(range, size) + "\r\n\r\n";
+            response.file_segments.push_back(
+                FileSegment(range.first, range.second - range.first + 1, part_header));
+        }
+        response.file_trailer = "\r\n--" + boundary + "--\r\n";
+    }
+    
+    response.headers["Content-Length"] = std::to_string(response.body_length());
 }
 
 void WebDAVServer::handle_put(const HTTPRequest& request, HTTPResponse& response) {
     std::string path = decode_url(request.uri);
     logger_->info("Handling PUT request for: " + path);
     
-    // 检查 Content-Length
-    auto content_length_it = request.headers.find("Content-Length");
-    if (content_length_it == request.headers.end()) {
+    // 检查 Content-Length，chunked 请求体的长度由连接层解码时确定
+    if (request.headers.find("Content-Length") == request.headers.end() &&
+        request.headers.find("Transfer-Encoding") == request.headers.end()) {
         logger_->error("Missing Content-Length header");
         response.status_code = 411;
         response.status_message = "Length Required";
         return;
     }
     
-    // 创建临时文件
-    std::string tmp_path = root_path_ + "/.tmp_" + std::to_string(time(nullptr)) + "_" + 
-                          std::to_string(rand());
-    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
-    if (fd < 0) {
-        logger_->error("Failed to create temp file: " + std::string(strerror(errno)));
+    // 检查文件是否已存在（用于决定返回状态码）
+    FileInfo info;
+    bool exists = file_manager_->get_resource_info(path, info);
+    if (exists && info.is_directory) {
+        response.status_code = 405;
+        response.status_message = "Method Not Allowed";
+        return;
+    }
+    
+    // 创建临时文件，已知长度时按 Content-Length 预分配空间
+    size_t expected_size = 0;
+    auto length_header = request.headers.find("Content-Length");
+    if (length_header != request.headers.end() && !parse_size(length_header->second, expected_size)) {
+        expected_size = 0;
+    }
+    FileWriter writer;
+    if (!file_manager_->write_file_stream(path, writer, expected_size)) {
         response.status_code = 500;
         response.status_message = "Internal Server Error";
         return;
     }
     
-    // 写入数据
-    const char* data = request.body.data();
-    size_t remaining = request.body.size();
+    // 边接收边写入，内存占用只有一个缓冲区
     size_t total_written = 0;
-    
-    while (remaining > 0) {
-        ssize_t written = write(fd, data + total_written, remaining);
-        if (written < 0) {
-            if (errno == EINTR) continue;
-            logger_->error("Failed to write file: " + std::string(strerror(errno)));
-            close(fd);
-            unlink(tmp_path.c_str());  // 删除临时文件
+    if (request.body_reader) {
+        std::vector<char> buffer(PUT_BUFFER_SIZE);
+        while (true) {
+            size_t bytes_read = 0;
+            if (!request.body_reader->read(buffer.data(), buffer.size(), bytes_read)) {
+                logger_->error("Failed to receive request body for: " + path);
+                file_manager_->abort_write(writer);
+                if (request.body_reader->timed_out()) {
+                    response.status_code = 408;
+                    response.status_message = "Request Timeout";
+                } else {
+                    response.status_code = 400;
+                    response.status_message = "Bad Request";
+                }
+                return;
+            }
+            if (bytes_read == 0) {
+                break;
+            }
+            if (!file_manager_->write_stream_data(writer, buffer.data(), bytes_read)) {
+                file_manager_->abort_write(writer);
+                response.status_code = 500;
+                response.status_message = "Internal Server Error";
+                return;
+            }
+            total_written += bytes_read;
+        }
+    } else if (!request.body.empty()) {
+        if (!file_manager_->write_stream_data(writer, request.body.data(), request.body.size())) {
+            file_manager_->abort_write(writer);
             response.status_code = 500;
             response.status_message = "Internal Server Error";
             return;
         }
-        total_written += written;
-        remaining -= written;
-    }
-    
-    // 同步并关闭文件
-    if (fsync(fd) < 0) {
-        logger_->error("Failed to sync file: " + std::string(strerror(errno)));
-    }
-    close(fd);
-    
-    // 创建目标目录（如果不存在）
-    std::string parent_path = path.substr(0, path.find_last_of('/'));
-    if (!parent_path.empty()) {
-        file_manager_->create_directory(parent_path);
+        total_written = request.body.size();
     }
     
-    // 移动临时文件到目标位置
-    std::string dest_path = root_path_ + path;
-    if (rename(tmp_path.c_str(), dest_path.c_str()) != 0) {
-        logger_->error("Failed to move temp file: " + std::string(strerror(errno)));
-        unlink(tmp_path.c_str());  // 删除临时文件
+    // 同步并原子替换目标文件
+    if (!file_manager_->finish_write(writer)) {
         response.status_code = 500;
         response.status_message = "Internal Server Error";
         return;
     }
     
-    // 检查文件是否已存在（用于决定返回状态码）
-    FileInfo info;
-    bool exists = file_manager_->get_resource_info(path, info);
-    
     // 设置响应
     response.status_code = exists ? 204 : 201;  // No Content : Created
     response.status_message = exists ? "No Content" : "Created";
     response.headers["Content-Length"] = "0";
     
     logger_->info("File uploaded successfully: " + path + 
-                 " (size: " + std::to_string(request.body.size()) + " bytes)");
+                 " (size: " + std::to_string(total_written) + " bytes)");
 }
 
 void WebDAVServer::handle_delete(const HTTPRequest& request, HTTPResponse& response) {
     std::string path = decode_url(request.uri);
     
-    if (!file_manager_->delete_resource(path)) {
-        response.status_code = 404;
-        response.status_message = "Not Found";
+    std::vector<FileManager::TreeFailure> failures;
+    if (!file_manager_->delete_resource(path, &failures)) {
+        if (failures.size() == 1 && failures[0].path == path) {
+            ErrorStatus status = error_status(failures[0].error);
+            response.status_code = status.code;
+            response.status_message = status.message;
+        } else {
+            logger_->warning("DELETE partially failed (" + std::to_string(failures.size()) +
+                             " members) for: " + path);
+            set_failure_multistatus(request.uri, path, failures, response);
+        }
         return;
     }
     
@@ -177,11 +364,31 @@ void WebDAVServer::handle_copy(const HTTPRequest& request, HTTPResponse& respons
         return;
     }
     
-    std::string dest_path = decode_url(dest_header->second);
-    
-    if (!file_manager_->copy_resource(src_path, dest_path)) {
-        response.status_code = 500;
-        response.status_message = "Internal Server Error";
+    std::string dest_uri = destination_uri_path(dest_header->second);
+    if (dest_uri.empty()) {
+        logger_->error("Invalid destination URL: " + dest_header->second);
+        response.status_code = 400;
+        response.status_message = "Bad Request";
+        return;
+    }
+    std::string dest_path = decode_url(dest_uri);
+    
+    std::vector<FileManager::TreeFailure> failures;
+    if (!file_manager_->copy_resource(src_path, dest_path, &failures)) {
+        if (failures.size() == 1 && failures[0].path == src_path) {
+            ErrorStatus status = error_status(failures[0].error);
+            response.status_code = status.code;
+            response.status_message = status.message;
+        } else if (failures.size() == 1 && failures[0].path == dest_path) {
+            // 目标的上级目录不存在时按 RFC 4918 返回 409
+            ErrorStatus status = error_status(failures[0].error);
+            response.status_code = status.code == 404 ? 409 : status.code;
+            response.status_message = status.code == 404 ? "Conflict" : status.message;
+        } else {
+            logger_->warning("COPY partially failed (" + std::to_string(failures.size()) +
+                             " members) for: " + src_path);
+            set_failure_multistatus(dest_uri, dest_path, failures, response);
+        }
         return;
     }
     
@@ -202,17 +409,14 @@ void WebDAVServer::handle_move(const HTTPRequest& request, HTTPResponse& respons
     }
     
     // 从 Destination URL 中提取路径
-    std::string dest_url = dest_header->second;
-    size_t path_start = dest_url.find('/', dest_url.find("://") + 3);
-    std::string dest_path;
-    if (path_start != std::string::npos) {
-        dest_path = decode_url(dest_url.substr(path_start));
-    } else {
-        logger_->error("Invalid destination URL: " + dest_url);
+    std::string dest_uri = destination_uri_path(dest_header->second);
+    if (dest_uri.empty()) {
+        logger_->error("Invalid destination URL: " + dest_header->second);
         response.status_code = 400;
         response.status_message = "Bad Request";
         return;
     }
+    std::string dest_path = decode_url(dest_uri);
     
     logger_->info("Moving to path: " + dest_path);
     
@@ -265,61 +469,242 @@ void WebDAVServer::handle_propfind(const HTTPRequest& request, HTTPResponse& res
     
     // 检查 Depth 头，默认为 infinity
     auto depth_header = request.headers.find("Depth");
-    int depth = (depth_header == request.headers.end() || depth_header->second == "infinity") 
-                ? -1 : std::stoi(depth_header->second);
-    
-    std::string xml_response = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
-                              "<D:multistatus xmlns:D=\"DAV:\">\n";
-    
-    xml_response += build_xml_response(request.uri, info);
+    int depth;
+    if (depth_header == request.headers.end() || strcasecmp(depth_header->second.c_str(), "infinity") == 0) {
+        depth = -1;
+    } else if (depth_header->second == "0" || depth_header->second == "1") {
+        depth = depth_header->second[0] - '0';
+    } else {
+        response.status_code = 400;
+        response.status_message = "Bad Request";
+        return;
+    }
     
-    // 只有在 depth > 0 且是目录时才列出内容
-    if (info.is_directory && depth != 0) {
-        std::vector<FileInfo> items;
-        if (file_manager_->list_directory(path, items)) {
-            for (const auto& item : items) {
-                xml_response += build_xml_response(request.uri + "/" + item.name, item);
-            }
+    // 禁止无限深度时按 RFC 4918 返回 403 并注明 propfind-finite-depth
+    if (depth < 0 && !config_.propfind_infinity) {
+        std::string xml_response = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+                                   "<D:error xmlns:D=\"DAV:\"><D:propfind-finite-depth/></D:error>";
+        response.status_code = 403;
+        response.status_message = "Forbidden";
+        response.headers["Content-Type"] = "application/xml; charset=utf-8";
+        response.body.assign(xml_response.begin(), xml_response.end());
+        return;
+    }
+    // 按请求体只生成客户端要的属性，空请求体等同于 allprop
+    PropfindRequest propfind;
+    if (!request.body.empty()) {
+        std::shared_ptr<XMLNode> root;
+        std::string body(request.body.begin(), request.body.end());
+        if (!xml_parser_->parse(body, root) || !build_propfind_request(root, propfind)) {
+            logger_->warning("Invalid PROPFIND body for: " + path);
+            response.status_code = 400;
+            response.status_message = "Bad Request";
+            return;
         }
     }
     
-    xml_response += "</D:multistatus>";
+    int max_depth = depth < 0 ? config_.propfind_max_depth : depth;
+    size_t max_entries = config_.propfind_max_entries;
+    
+    // 单层列表可按 Prefer: page-size=N 分页：每页只读出 N 个子项，后续请求在 Prefer 中带上
+    // page-token 续读。还有剩余时只由 Page-Token 响应头给出下一页的令牌：507 专用于真正的截断，
+    // 不理解分页的客户端不会把尚未读取的页误认为出错
+    size_t page_size = 0;
+    std::string page_token;
+    auto prefer_header = request.headers.find("Prefer");
+    if (prefer_header != request.headers.end()) {
+        parse_paging_preference(prefer_header->second, page_size, page_token);
+    }
+    std::shared_ptr<std::vector<FileInfo>> page;
+    std::string next_token;
+    if (page_size > 0 && depth == 1 && info.is_directory) {
+        page_size = std::min(page_size, max_entries);
+        page = std::make_shared<std::vector<FileInfo>>();
+        next_token = page_token;
+        if (!file_manager_->list_directory_page(path, next_token, page_size, *page)) {
+            logger_->warning("Invalid PROPFIND page token for: " + path);
+            response.status_code = 400;
+            response.status_message = "Bad Request";
+            return;
+        }
+        response.headers["Preference-Applied"] = "page-size=" + std::to_string(page_size);
+        if (!next_token.empty()) {
+            response.headers["Page-Token"] = next_token;
+        }
+    }
     
     response.status_code = 207;
     response.status_message = "Multi-Status";
     response.headers["Content-Type"] = "application/xml; charset=utf-8";
-    response.headers["Content-Length"] = std::to_string(xml_response.length());
-    response.body = std::vector<char>(xml_response.begin(), xml_response.end());
+    
+    // 多状态响应边遍历边发送，内存占用与目录树的规模无关
+    std::string uri = request.uri;
+    bool first_page = page_token.empty();
+    bool infinite = depth < 0;
+    response.body_producer = [this, uri, path, info, propfind, max_depth, max_entries,
+                              page, first_page, infinite](const BodyWriter& write) {
+        MultistatusWriter writer(MULTISTATUS_FLUSH_SIZE + 4096);
+        writer.begin();
+        // 分页时集合本身只出现在第一页
+        if (!page || first_page) {
+            writer.add_response(uri, "", info, propfind);
+        }
+        
+        auto flush = [&writer, &write]() {
+            bool ok = write(writer.data(), writer.size());
+            writer.clear();
+            return ok;
+        };
+        
+        // 子项的 href 由请求 URI 加上相对于请求路径的部分（编码后）组成
+        std::string base_uri = uri;
+        std::string base_path = path;
+        while (!base_uri.empty() && base_uri.back() == '/') base_uri.pop_back();
+        while (!base_path.empty() && base_path.back() == '/') base_path.pop_back();
+        
+        size_t entries = 1;
+        bool truncated = false;
+        bool depth_truncated = false;
+        bool sent = true;
+        auto emit = [&](const FileInfo& item, int item_depth) {
+            if (entries >= max_entries) {
+                truncated = true;
+                return false;
+            }
+            ++entries;
+            // Depth: infinity 在最大层级处遇到目录时没有进入，结果不完整
+            if (infinite && item_depth == max_depth && item.is_directory) {
+                depth_truncated = true;
+            }
+            writer.add_response(base_uri, item.path.substr(base_path.size()), item, propfind);
+            if (writer.size() >= MULTISTATUS_FLUSH_SIZE) {
+                sent = flush();
+            }
+            return sent;
+        };
+        // 无法读取的子目录不当作空目录列出，而是给出该成员的错误状态
+        auto emit_error = [&](const FileInfo& item, int, int error) {
+            if (entries >= max_entries) {
+                truncated = true;
+                return false;
+            }
+            ++entries;
+            logger_->warning("PROPFIND cannot read directory " + item.path + ": " + strerror(error));
+            writer.add_member_status(base_uri, item.path.substr(base_path.size()), error_status(error).status_line);
+            if (writer.size() >= MULTISTATUS_FLUSH_SIZE) {
+                sent = flush();
+            }
+            return sent;
+        };
+        
+        if (page) {
+            for (const auto& item : *page) {
+                writer.add_response(base_uri, item.path.substr(base_path.size()), item, propfind);
+                if (writer.size() >= MULTISTATUS_FLUSH_SIZE && !flush()) {
+                    return false;
+                }
+            }
+        } else if (info.is_directory && max_depth == 1) {
+            // 单层列表走目录缓存，未变化的目录不必访问文件系统
+            std::vector<FileInfo> items;
+            if (file_manager_->list_directory(path, items)) {
+                for (const auto& item : items) {
+                    if (!emit(item, 1)) {
+                        break;
+                    }
+                }
+            }
+        } else if (info.is_directory && max_depth > 1) {
+            file_manager_->walk_directory(path, max_depth, emit, emit_error);
+        }
+        if (!sent) {
+            return false;
+        }
+        
+        // 条目数或层级超出上限时结果被截断，按 RFC 4918 以请求 URI 的 507 状态告知客户端
+        if (truncated) {
+            logger_->warning("PROPFIND result truncated at " + std::to_string(max_entries) +
+                             " entries for: " + path);
+        } else if (depth_truncated) {
+            logger_->warning("PROPFIND result truncated at depth " + std::to_string(max_depth) + " for: " + path);
+        }
+        if (truncated || depth_truncated) {
+            writer.add_status(uri, "HTTP/1.1 507 Insufficient Storage", "D:number-of-matches-within-limits");
+        }
+        writer.end();
+        return flush();
+    };
 }
 
 void WebDAVServer::handle_proppatch(const HTTPRequest& request, HTTPResponse& response) {
     std::string path = decode_url(request.uri);
     logger_->info("Handling PROPPATCH request for: " + path);
     
-    // 直接返回成功，不实际修改属性
+    FileInfo info;
+    if (!file_manager_->get_resource_info(path, info)) {
+        response.status_code = 404;
+        response.status_message = "Not Found";
+        return;
+    }
+    
+    std::shared_ptr<XMLNode> root;
+    std::vector<PropertyOperation> operations;
+    std::string body(request.body.begin(), request.body.end());
+    if (!xml_parser_->parse(body, root) || !build_proppatch_request(root, operations)) {
+        logger_->warning("Invalid PROPPATCH body for: " + path);
+        response.status_code = 400;
+        response.status_message = "Bad Request";
+        return;
+    }
+    
+    // 按文档顺序合并成最终的设置和删除集合，活属性不允许修改
+    std::map<std::string, std::string> set;
+    std::vector<std::string> remove;
+    std::vector<std::pair<std::string, std::string>> names;
+    std::vector<std::pair<std::string, std::string>> protected_names;
+    for (const auto& op : operations) {
+        names.push_back(std::make_pair(op.ns, op.local_name));
+        if (live_property_bit(op.ns, op.local_name)) {
+            protected_names.push_back(names.back());
+            continue;
+        }
+        std::string key = clark_name(op.ns, op.local_name);
+        if (op.remove) {
+            set.erase(key);
+            remove.push_back(key);
+        } else {
+            set[key] = op.value;
+        }
+    }
+    
+    // 所有操作要么全部生效要么全部不生效（RFC 4918 9.2）
+    MultistatusWriter writer(4096);
+    writer.begin();
+    writer.begin_response(request.uri);
+    if (!protected_names.empty()) {
+        std::vector<std::pair<std::string, std::string>> others;
+        for (const auto& name : names) {
+            if (!live_property_bit(name.first, name.second)) {
+                others.push_back(name);
+            }
+        }
+        writer.add_propstat(protected_names, "HTTP/1.1 403 Forbidden");
+        if (!others.empty()) {
+            writer.add_propstat(others, "HTTP/1.1 424 Failed Dependency");
+        }
+    } else if (file_manager_->update_properties(path, set, remove)) {
+        writer.add_propstat(names, "HTTP/1.1 200 OK");
+    } else {
+        logger_->error("Failed to store properties for: " + path);
+        writer.add_propstat(names, "HTTP/1.1 500 Internal Server Error");
+    }
+    writer.end_response();
+    writer.end();
+    
     response.status_code = 207;  // Multi-Status
     response.status_message = "Multi-Status";
     response.headers["Content-Type"] = "application/xml; charset=utf-8";
-    
-    // 构建响应 XML
-    std::string xml_response = 
-        "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
-        "<D:multistatus xmlns:D=\"DAV:\">\n"
-        "  <D:response>\n"
-        "    <D:href>" + request.uri + "</D:href>\n"
-        "    <D:propstat>\n"
-        "      <D:prop>\n"
-        "        <Win32LastModifiedTime/>\n"
-        "        <Win32FileAttributes/>\n"
-        "        <Win32CreationTime/>\n"
-        "        <Win32LastAccessTime/>\n"
-        "      </D:prop>\n"
-        "      <D:status>HTTP/1.1 200 OK</D:status>\n"
-        "    </D:propstat>\n"
-        "  </D:response>\n"
-        "</D:multistatus>";
-    
-    response.body = std::vector<char>(xml_response.begin(), xml_response.end());
+    response.body.assign(writer.data(), writer.data() + writer.size());
     response.headers["Content-Length"] = std::to_string(response.body.size());
 }
 
@@ -327,6 +712,10 @@ void WebDAVServer::handle_head(const HTTPRequest& request, HTTPResponse& respons
     // HEAD 方法与 GET 相同，但不返回响应体
     handle_get(request, response);
     response.body.clear();
+    if (response.file_fd >= 0) {
+        close(response.file_fd);
+        response.file_fd = -1;
+    }
 }
 
 } // namespace webdav 
\ No newline at end of file
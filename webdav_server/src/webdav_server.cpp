@@ -6,6 +6,7 @@
 #include "xml_parser.h"
 #include "base64.h"
 #include "mime_types.h"
+#include "chunked.h"
 
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -15,21 +16,283 @@
 #include <cstring>
 #include <sstream>
 #include <fcntl.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
+#include <poll.h>
+#include <sched.h>
 #include <errno.h>
+#include <strings.h>
+#include <cstdint>
 #include <thread>
 #include <mutex>
 #include <algorithm>
+#include <chrono>
 
 namespace webdav {
 
-WebDAVServer::WebDAVServer(const std::string& host, int port, const std::string& root_path)
-    : host_(host), port_(port), root_path_(root_path), running_(false) {
+namespace {
+
+const size_t READ_CHUNK_SIZE = 8192;            // 每次 recv 的大小
+const size_t MAX_HEADER_SIZE = 64 * 1024;       // 请求头上限
+const size_t MAX_BUFFERED_BODY = 16 * 1024 * 1024;  // 非流式请求体在内存中的上限
+const int MAX_EVENTS = 256;
+const int KEEP_ALIVE_TIMEOUT = 30;              // 空闲连接超时（秒）
+const int SEND_TIMEOUT_MS = 30000;
+const int UPLOAD_GRACE_MS = 10000;              // 流式请求体开始计算最低速率前的宽限期
+const size_t MIN_UPLOAD_RATE = 4096;            // 流式请求体的最低平均速率（字节/秒）
+const size_t SENDFILE_CHUNK_SIZE = 4 * 1024 * 1024;
+const int MAX_PIPELINED_PER_TURN = 16;          // 每次调度最多连续处理的流水线请求数
+const int STATS_LOG_INTERVAL = 60;              // 线程池和缓存统计日志间隔（秒）
+const char* const RETRY_AFTER_SECONDS = "1";
+const uint32_t CLIENT_EVENTS = EPOLLIN | EPOLLRDHUP | EPOLLET | EPOLLONESHOT;
+
+bool parse_content_length(const StringView& value, size_t& length) {
+    if (value.size == 0) {
+        return false;
+    }
+    size_t parsed = 0;
+    for (size_t i = 0; i < value.size; ++i) {
+        char c = value.data[i];
+        if (c < '0' || c > '9' || parsed > (SIZE_MAX - (c - '0')) / 10) {
+            return false;
+        }
+        parsed = parsed * 10 + (c - '0');
+    }
+    length = parsed;
+    return true;
+}
+
+// 在非阻塞 socket 上等待指定事件
+bool wait_socket(int socket_fd, short events, int timeout_ms = SEND_TIMEOUT_MS) {
+    struct pollfd pfd;
+    pfd.fd = socket_fd;
+    pfd.events = events;
+    pfd.revents = 0;
+    while (true) {
+        int ready = poll(&pfd, 1, timeout_ms);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        return ready > 0;
+    }
+}
+
+// 发送缓冲区已满时等待其可写
+bool wait_writable(int socket_fd) {
+    return wait_socket(socket_fd, POLLOUT);
+}
+
+const char CONTINUE_RESPONSE[] = "HTTP/1.1 100 Continue\r\n\r\n";
+
+// 流式请求体的接收期限：读取期间一直占着工作线程，只限制单次等待时，客户端每隔不到 30 秒
+// 发一个字节就能无限期占住它。宽限期过后要求平均速率不低于 MIN_UPLOAD_RATE，
+// 即每收到一批数据，截止时间按其字节数顺延
+class UploadDeadline {
+public:
+    UploadDeadline() : start_(std::chrono::steady_clock::now()), received_(0), expired_(false) {}
+
+    void received(size_t bytes) { received_ += bytes; }
+
+    // 等待数据到达，截止时间已过或单次等待超时返回 false
+    bool wait(int socket_fd) {
+        std::chrono::steady_clock::time_point deadline =
+            start_ + std::chrono::milliseconds(UPLOAD_GRACE_MS + received_ * 1000 / MIN_UPLOAD_RATE);
+        long long left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0 ||
+            !wait_socket(socket_fd, POLLIN, static_cast<int>(std::min<long long>(left, SEND_TIMEOUT_MS)))) {
+            expired_ = true;
+            return false;
+        }
+        return true;
+    }
+
+    bool expired() const { return expired_; }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+    size_t received_;
+    bool expired_;
+};
+
+bool expects_continue(const HTTPRequest& request) {
+    auto it = request.headers.find("Expect");
+    return it != request.headers.end() && strcasecmp(it->second.c_str(), "100-continue") == 0;
+}
+
+// HTTP/1.1 默认保持连接，HTTP/1.0 需显式声明 keep-alive
+bool wants_keep_alive(const HTTPRequest& request) {
+    auto it = request.headers.find("Connection");
+    if (request.version == "HTTP/1.0") {
+        return it != request.headers.end() && strcasecmp(it->second.c_str(), "keep-alive") == 0;
+    }
+    return it == request.headers.end() || strcasecmp(it->second.c_str(), "close") != 0;
+}
+
+// PUT 的请求体直接从 socket 流式写盘，不在连接缓冲区中攒齐
+bool streams_body(const HTTPRequest& request) {
+    return request.method == HTTPMethod::PUT;
+}
+
+// 从连接上读取 Content-Length 定长的请求体：先消费事件循环已读入的部分，再直接 recv
+class SocketBodyReader : public BodyReader {
+public:
+    SocketBodyReader(int socket_fd, const char* buffered, size_t buffered_size,
+                     size_t content_length, bool expect_continue)
+        : socket_fd_(socket_fd), buffered_(buffered), buffered_size_(buffered_size),
+          remaining_(content_length), expect_continue_(expect_continue && buffered_size == 0) {}
+
+    bool read(char* buffer, size_t size, size_t& bytes_read) override {
+        bytes_read = 0;
+        if (remaining_ == 0 || size == 0) {
+            return true;
+        }
+        size_t wanted = std::min(size, remaining_);
+        
+        if (buffered_size_ > 0) {
+            bytes_read = std::min(wanted, buffered_size_);
+            memcpy(buffer, buffered_, bytes_read);
+            buffered_ += bytes_read;
+            buffered_size_ -= bytes_read;
+            remaining_ -= bytes_read;
+            deadline_.received(bytes_read);
+            return true;
+        }
+        
+        // 客户端在等待 100 Continue 才发送请求体
+        if (expect_continue_) {
+            expect_continue_ = false;
+            if (send(socket_fd_, CONTINUE_RESPONSE, sizeof(CONTINUE_RESPONSE) - 1, MSG_NOSIGNAL) < 0) {
+                return false;
+            }
+        }
+        
+        while (true) {
+            ssize_t n = recv(socket_fd_, buffer, wanted, 0);
+            if (n > 0) {
+                bytes_read = n;
+                remaining_ -= n;
+                deadline_.received(n);
+                return true;
+            }
+            if (n == 0) {
+                return false;  // 请求体收齐前客户端断开
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            if ((errno == EAGAIN || errno == EWOULDBLOCK) && deadline_.wait(socket_fd_)) {
+                continue;
+            }
+            return false;
+        }
+    }
+
+    bool timed_out() const override { return deadline_.expired(); }
+    size_t remaining() const { return remaining_; }
+
+private:
+    int socket_fd_;
+    const char* buffered_;
+    size_t buffered_size_;
+    size_t remaining_;
+    bool expect_continue_;
+    UploadDeadline deadline_;
+};
+
+// 读取 chunked 编码的请求体：原始数据留在连接缓冲区中边解码边消费，
+// 读到结束块后缓冲区里剩下的字节属于下一个流水线请求
+class ChunkedBodyReader : public BodyReader {
+public:
+    ChunkedBodyReader(Connection& conn, bool expect_continue)
+        : conn_(conn), expect_continue_(expect_continue && conn.buffer.size() == conn.header_size),
+          malformed_(false) {}
+
+    bool read(char* buffer, size_t size, size_t& bytes_read) override {
+        bytes_read = 0;
+        while (bytes_read == 0 && size > 0 && !decoder_.done()) {
+            size_t start = conn_.header_size + conn_.body_consumed;
+            if (start == conn_.buffer.size()) {
+                if (!fill()) {
+                    return false;
+                }
+                continue;
+            }
+            
+            size_t consumed = 0;
+            ChunkedDecoder::Status status = decoder_.decode(
+                conn_.buffer.data() + start, conn_.buffer.size() - start, consumed,
+                buffer, size, bytes_read);
+            conn_.body_consumed += consumed;
+            if (status == ChunkedDecoder::Status::ERROR) {
+                malformed_ = true;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool timed_out() const override { return deadline_.expired(); }
+    bool finished() const { return decoder_.done(); }
+    bool malformed() const { return malformed_; }
+    const std::string& error() const { return decoder_.error(); }
+
+private:
+    // 缓冲区已解码完，丢弃已消费的部分后从 socket 继续接收
+    bool fill() {
+        conn_.buffer.clear();
+        conn_.header_size = 0;
+        conn_.body_consumed = 0;
+        
+        if (expect_continue_) {
+            expect_continue_ = false;
+            if (send(conn_.fd, CONTINUE_RESPONSE, sizeof(CONTINUE_RESPONSE) - 1, MSG_NOSIGNAL) < 0) {
+                return false;
+            }
+        }
+        
+        conn_.buffer.resize(READ_CHUNK_SIZE);
+        while (true) {
+            ssize_t n = recv(conn_.fd, conn_.buffer.data(), conn_.buffer.size(), 0);
+            if (n > 0) {
+                conn_.buffer.resize(n);
+                deadline_.received(n);
+                return true;
+            }
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && deadline_.wait(conn_.fd)) {
+                continue;
+            }
+            conn_.buffer.clear();
+            return false;  // 请求体结束前客户端断开
+        }
+    }
+
+    Connection& conn_;
+    ChunkedDecoder decoder_;
+    bool expect_continue_;
+    bool malformed_;
+    UploadDeadline deadline_;
+};
+
+} // namespace
+
+WebDAVServer::WebDAVServer(const std::string& host, int port, const std::string& root_path,
+                           const ServerConfig& config)
+    : host_(host), port_(port), root_path_(root_path), config_(config), running_(false) {
     logger_.reset(new Logger("logs/webdav.log", Logger::Level::INFO));
     auth_manager_.reset(new AuthManager());
     http_parser_.reset(new HTTPParser(*logger_));
-    file_manager_.reset(new FileManager(root_path, *logger_));
+    file_manager_.reset(new FileManager(root_path, *logger_, config_.metadata_cache_bytes,
+                                        config_.traversal_threads));
+    if (!file_manager_->open_property_store(config_.property_store)) {
+        logger_->error("Dead properties are unavailable, PROPPATCH will fail");
+    }
+    file_manager_->set_durability(config_.durability, config_.group_commit_us);
     xml_parser_.reset(new XMLParser());
     
     logger_->info("WebDAV server initializing...");
@@ -42,17 +305,115 @@ WebDAVServer::~WebDAVServer() {
 bool WebDAVServer::start() {
     logger_->info("Starting server on " + host_ + ":" + std::to_string(port_));
     
-    server_socket_ = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_socket_ < 0) {
+    // 多监听模式：每个事件循环各自持有一个 SO_REUSEPORT 监听 socket，由内核分配新连接
+    size_t loop_count = config_.listeners;
+    if (loop_count == 0) {
+        loop_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    bool reuse_port = loop_count > 1;
+    unsigned int cpu_count = std::max(1u, std::thread::hardware_concurrency());
+    
+    for (size_t i = 0; i < loop_count; ++i) {
+        int listen_fd = create_listen_socket(reuse_port);
+        if (listen_fd < 0) {
+            if (reuse_port && i == 0) {
+                logger_->warning("SO_REUSEPORT unavailable, falling back to a single listener");
+                reuse_port = false;
+                loop_count = 1;
+                listen_fd = create_listen_socket(false);
+            }
+            if (listen_fd < 0) {
+                destroy_event_loops();
+                return false;
+            }
+        }
+        
+        std::unique_ptr<EventLoop> loop(new EventLoop());
+        loop->index = static_cast<int>(i);
+        loop->cpu = reuse_port ? static_cast<int>(i % cpu_count) : -1;
+        loop->listen_fd = listen_fd;
+        loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        loop->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        loops_.push_back(std::move(loop));
+        
+        EventLoop* current = loops_.back().get();
+        if (current->epoll_fd < 0 || current->wake_fd < 0) {
+            logger_->error("Failed to create event loop: " + std::string(strerror(errno)));
+            destroy_event_loops();
+            return false;
+        }
+        
+        // 监听 socket 使用水平触发，accept 失败（如 EMFILE）时下一轮还能再次收到通知
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = current->listen_fd;
+        epoll_ctl(current->epoll_fd, EPOLL_CTL_ADD, current->listen_fd, &ev);
+        ev.data.fd = current->wake_fd;
+        epoll_ctl(current->epoll_fd, EPOLL_CTL_ADD, current->wake_fd, &ev);
+    }
+
+    running_ = true;
+
+    thread_pool_.reset(new ThreadPool(config_.worker_threads, config_.max_queued_requests));
+    ThreadPool::Stats stats = thread_pool_->get_stats();
+    logger_->info("Worker pool: " + std::to_string(stats.threads) + " threads, queue capacity " +
+                  std::to_string(stats.queue_capacity));
+    
+    for (auto& loop : loops_) {
+        loop->thread = std::thread(&WebDAVServer::run_event_loop, this, loop.get());
+    }
+    logger_->info("Started " + std::to_string(loops_.size()) + " event loop(s)" +
+                  (reuse_port ? " with SO_REUSEPORT listeners" : ""));
+
+    logger_->info("Server started successfully");
+    return true;
+}
+
+void WebDAVServer::stop() {
+    if (running_) {
+        running_ = false;
+        
+        // 唤醒事件循环并等待其退出
+        for (auto& loop : loops_) {
+            uint64_t one = 1;
+            if (write(loop->wake_fd, &one, sizeof(one)) < 0) {
+                logger_->error("Failed to wake event loop: " + std::string(strerror(errno)));
+            }
+        }
+        for (auto& loop : loops_) {
+            if (loop->thread.joinable()) {
+                loop->thread.join();
+            }
+        }
+        
+        // 丢弃排队中的请求并等待所有工作线程结束
+        thread_pool_->shutdown();
+        
+        destroy_event_loops();
+        
+        logger_->info("WebDAV server stopped");
+    }
+}
+
+int WebDAVServer::create_listen_socket(bool reuse_port) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
         logger_->error("Failed to create socket: " + std::string(strerror(errno)));
-        return false;
+        return -1;
     }
 
     int opt = 1;
-    if (setsockopt(server_socket_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+    if (setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
         logger_->error("Failed to set SO_REUSEADDR: " + std::string(strerror(errno)));
-        close(server_socket_);
-        return false;
+        close(listen_fd);
+        return -1;
+    }
+    
+    if (reuse_port && setsockopt(listen_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        logger_->error("Failed to set SO_REUSEPORT: " + std::string(strerror(errno)));
+        close(listen_fd);
+        return -1;
     }
 
     struct sockaddr_in server_addr;
@@ -61,90 +422,121 @@ bool WebDAVServer::start() {
     server_addr.sin_port = htons(port_);
     if (inet_pton(AF_INET, host_.c_str(), &server_addr.sin_addr) <= 0) {
         logger_->error("Invalid address: " + host_);
-        close(server_socket_);
-        return false;
+        close(listen_fd);
+        return -1;
     }
 
-    if (bind(server_socket_, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+    if (bind(listen_fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
         logger_->error("Failed to bind socket: " + std::string(strerror(errno)));
-        close(server_socket_);
-        return false;
+        close(listen_fd);
+        return -1;
     }
 
-    if (listen(server_socket_, SOMAXCONN) < 0) {
+    if (listen(listen_fd, SOMAXCONN) < 0) {
         logger_->error("Failed to listen on socket: " + std::string(strerror(errno)));
-        close(server_socket_);
-        return false;
+        close(listen_fd);
+        return -1;
     }
-
-    running_ = true;
-    std::thread accept_thread(&WebDAVServer::accept_connections, this);
-    accept_thread.detach();
-
-    logger_->info("Server started successfully");
-    return true;
+    
+    return listen_fd;
 }
 
-void WebDAVServer::stop() {
-    if (running_) {
-        running_ = false;
-        close(server_socket_);
-        
-        // 等待所有工作线程结束
+void WebDAVServer::destroy_event_loops() {
+    for (auto& loop : loops_) {
+        // 关闭剩余的客户端连接
         {
-            std::lock_guard<std::mutex> lock(threads_mutex_);
-            for (auto& thread : worker_threads_) {
-                if (thread.joinable()) {
-                    thread.join();
-                }
+            std::lock_guard<std::mutex> lock(loop->connections_mutex);
+            for (auto& entry : loop->connections) {
+                close(entry.first);
             }
-            worker_threads_.clear();
+            loop->connections.clear();
         }
-        
-        logger_->info("WebDAV server stopped");
+        if (loop->epoll_fd >= 0) close(loop->epoll_fd);
+        if (loop->wake_fd >= 0) close(loop->wake_fd);
+        if (loop->listen_fd >= 0) close(loop->listen_fd);
     }
+    loops_.clear();
 }
 
-void WebDAVServer::accept_connections() {
-    // 设置服务器 socket 为非阻塞模式
-    int flags = fcntl(server_socket_, F_GETFL, 0);
-    fcntl(server_socket_, F_SETFL, flags | O_NONBLOCK);
+void WebDAVServer::run_event_loop(EventLoop* loop) {
+    // 多监听模式下把事件循环绑定到固定核心
+    if (loop->cpu >= 0) {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(loop->cpu, &cpu_set);
+        if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+            logger_->warning("Failed to pin event loop " + std::to_string(loop->index) +
+                             " to CPU " + std::to_string(loop->cpu) + ": " + strerror(errno));
+        }
+    }
     
-    fd_set read_fds;
-    struct timeval tv;
+    std::vector<struct epoll_event> events(MAX_EVENTS);
+    time_t last_sweep = time(nullptr);
+    time_t last_stats = last_sweep;
     
     while (running_) {
-        FD_ZERO(&read_fds);
-        FD_SET(server_socket_, &read_fds);
-        
-        tv.tv_sec = 0;
-        tv.tv_usec = 10000;  // 改为 10ms 超时，让响应更快
-        
-        int ready = select(server_socket_ + 1, &read_fds, NULL, NULL, &tv);
+        int ready = epoll_wait(loop->epoll_fd, events.data(), MAX_EVENTS, 1000);
         if (ready < 0) {
             if (errno != EINTR) {
-                logger_->error("Select error: " + std::string(strerror(errno)));
+                logger_->error("epoll_wait error: " + std::string(strerror(errno)));
                 break;
             }
             continue;
         }
         
-        if (ready == 0) {  // 超时
-            continue;
+        for (int i = 0; i < ready; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == loop->listen_fd) {
+                accept_connections(loop);
+                continue;
+            }
+            if (fd == loop->wake_fd) {
+                uint64_t value;
+                while (read(fd, &value, sizeof(value)) > 0) {}
+                continue;
+            }
+            
+            std::shared_ptr<Connection> conn;
+            {
+                std::lock_guard<std::mutex> lock(loop->connections_mutex);
+                auto it = loop->connections.find(fd);
+                if (it != loop->connections.end()) {
+                    conn = it->second;
+                }
+            }
+            if (conn) {
+                handle_readable(loop, conn);
+            }
         }
         
+        // 每秒清理一次空闲的 keep-alive 连接
+        time_t now = time(nullptr);
+        if (now != last_sweep) {
+            close_idle_connections(loop);
+            last_sweep = now;
+        }
+        if (loop->index == 0 && now - last_stats >= STATS_LOG_INTERVAL) {
+            log_worker_stats();
+            last_stats = now;
+        }
+    }
+}
+
+void WebDAVServer::accept_connections(EventLoop* loop) {
+    while (running_) {
         struct sockaddr_in client_addr;
         socklen_t client_len = sizeof(client_addr);
-        int client_socket = accept(server_socket_, (struct sockaddr*)&client_addr, &client_len);
+        int client_socket = accept4(loop->listen_fd, (struct sockaddr*)&client_addr, &client_len,
+                                    SOCK_NONBLOCK | SOCK_CLOEXEC);
         
         if (client_socket < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            if (errno == EINTR) {
                 continue;
             }
-            if (running_) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
                 logger_->error("Failed to accept connection: " + std::string(strerror(errno)));
             }
-            continue;
+            return;
         }
         
         std::string client_ip = inet_ntoa(client_addr.sin_addr);
@@ -155,13 +547,6 @@ void WebDAVServer::accept_connections() {
         int keepalive = 1;
         setsockopt(client_socket, SOL_SOCKET, SO_KEEPALIVE, &keepalive, sizeof(keepalive));
 
-        // 设置超时和缓冲区大小
-        struct timeval timeout;
-        timeout.tv_sec = 30;  // 30 秒
-        timeout.tv_usec = 0;
-        setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-        setsockopt(client_socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
-
         int buffer_size = 1024 * 1024;  // 1MB
         setsockopt(client_socket, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
         setsockopt(client_socket, SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size));
@@ -169,120 +554,494 @@ void WebDAVServer::accept_connections() {
         int nodelay = 1;
         setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
 
-        if (client_socket >= 0) {
-            // 创建新线程
-            {
-                std::lock_guard<std::mutex> lock(threads_mutex_);
-                
-                // 清理已完成的线程
-                for (auto it = worker_threads_.begin(); it != worker_threads_.end();) {
-                    if (it->joinable()) {
-                        it->join();
-                        it = worker_threads_.erase(it);
-                    } else {
-                        ++it;
-                    }
-                }
-                
-                // 添加新线程
-                worker_threads_.emplace_back(std::thread([this, client_socket]() {
-                    handle_client(client_socket);
-                }));
+        std::shared_ptr<Connection> conn(
+            new Connection(client_socket, client_ip + ":" + std::to_string(client_port)));
+        {
+            std::lock_guard<std::mutex> lock(loop->connections_mutex);
+            loop->connections[client_socket] = conn;
+        }
+        
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = CLIENT_EVENTS;
+        ev.data.fd = client_socket;
+        if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, client_socket, &ev) < 0) {
+            logger_->error("Failed to register client socket: " + std::string(strerror(errno)));
+            close_connection(loop, conn);
+        }
+    }
+}
+
+void WebDAVServer::handle_readable(EventLoop* loop, const std::shared_ptr<Connection>& conn) {
+    if (conn->busy) {
+        return;
+    }
+    
+    // 边缘触发：一直读到 EAGAIN 为止
+    bool peer_closed = false;
+    while (true) {
+        size_t old_size = conn->buffer.size();
+        conn->buffer.resize(old_size + READ_CHUNK_SIZE);
+        ssize_t bytes_read = recv(conn->fd, conn->buffer.data() + old_size, READ_CHUNK_SIZE, 0);
+        if (bytes_read > 0) {
+            conn->buffer.resize(old_size + bytes_read);
+            continue;
+        }
+        conn->buffer.resize(old_size);
+        if (bytes_read == 0) {
+            peer_closed = true;
+            break;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        logger_->error("Receive error: " + std::string(strerror(errno)));
+        close_connection(loop, conn);
+        return;
+    }
+    conn->last_active = time(nullptr);
+    
+    ParseResult result = parse_buffered_request(conn);
+    if (result == ParseResult::FAILED) {
+        close_connection(loop, conn);
+        return;
+    }
+    
+    if (result == ParseResult::NEED_MORE) {
+        if (peer_closed) {
+            logger_->debug(conn->buffer.empty() ? "Client closed connection normally"
+                                                : "Client closed connection during request read");
+            close_connection(loop, conn);
+        } else if (!rearm_connection(loop, conn)) {
+            close_connection(loop, conn);
+        }
+        return;
+    }
+    
+    // 请求完整，交给工作线程处理
+    conn->busy = true;
+    if (!thread_pool_->submit([this, loop, conn]() { process_connection(loop, conn); })) {
+        conn->busy = false;
+        reject_overloaded(loop, conn);
+    }
+}
+
+WebDAVServer::ParseResult WebDAVServer::parse_buffered_request(const std::shared_ptr<Connection>& conn) {
+    if (conn->header_size == 0) {
+        // 解析器从上次停下的位置继续，只处理新到的数据
+        RequestParser& parser = conn->parser;
+        RequestParser::Status status = parser.parse(conn->buffer.data(), conn->buffer.size());
+        if (status == RequestParser::Status::ERROR) {
+            logger_->error("Failed to parse request from " + conn->peer + ": " + parser.error());
+            send_error_response(conn->fd, 400, "Bad Request");
+            return ParseResult::FAILED;
+        }
+        
+        if (status == RequestParser::Status::INCOMPLETE) {
+            if (conn->buffer.size() > MAX_HEADER_SIZE) {
+                logger_->error("Request header too large from " + conn->peer);
+                send_error_response(conn->fd, 431, "Request Header Fields Too Large");
+                return ParseResult::FAILED;
+            }
+            return ParseResult::NEED_MORE;
+        }
+        
+        // 请求头完整：Content-Length 直接从缓冲区视图读取，之后一次性生成 HTTPRequest
+        const char* data = conn->buffer.data();
+        conn->header_size = parser.header_size();
+        
+        // 同名头部取值不一致时，前后两个服务器可能各取其一，据此划分的请求边界不同（请求走私）
+        if (parser.has_conflicting_header(data, "Content-Length") ||
+            parser.has_conflicting_header(data, "Transfer-Encoding")) {
+            logger_->error("Conflicting Content-Length or Transfer-Encoding headers from " + conn->peer);
+            send_error_response(conn->fd, 400, "Bad Request");
+            return ParseResult::FAILED;
+        }
+        
+        StringView content_length;
+        bool has_length = parser.find_header(data, "Content-Length", content_length);
+        if (has_length && !parse_content_length(content_length, conn->content_length)) {
+            logger_->error("Invalid Content-Length: " + content_length.str());
+            send_error_response(conn->fd, 400, "Bad Request");
+            return ParseResult::FAILED;
+        }
+        
+        // 只支持单独的 chunked 编码；与 Content-Length 同时出现可能被用于请求走私，直接拒绝
+        StringView transfer_encoding;
+        if (parser.find_header(data, "Transfer-Encoding", transfer_encoding)) {
+            if (!transfer_encoding.equals_ignore_case("chunked")) {
+                logger_->error("Unsupported Transfer-Encoding: " + transfer_encoding.str());
+                send_error_response(conn->fd, 501, "Not Implemented");
+                return ParseResult::FAILED;
+            }
+            if (has_length) {
+                logger_->error("Both Transfer-Encoding and Content-Length from " + conn->peer);
+                send_error_response(conn->fd, 400, "Bad Request");
+                return ParseResult::FAILED;
+            }
+            conn->chunked = true;
+        }
+        
+        parser.to_request(data, conn->request);
+        if (conn->request.method == HTTPMethod::UNKNOWN) {
+            logger_->error("Unknown HTTP method: [" + parser.method_name(data).str() + "]");
+        }
+        
+        if (!streams_body(conn->request) && !conn->chunked && conn->content_length > 0) {
+            if (conn->content_length > MAX_BUFFERED_BODY) {
+                logger_->error("Request body too large from " + conn->peer);
+                send_error_response(conn->fd, 413, "Payload Too Large");
+                return ParseResult::FAILED;
+            }
+            if (conn->buffer.size() == conn->header_size && expects_continue(conn->request)) {
+                send(conn->fd, CONTINUE_RESPONSE, sizeof(CONTINUE_RESPONSE) - 1, MSG_NOSIGNAL);
             }
         }
     }
+    
+    // 请求体尚未收齐，继续等待（流式和 chunked 请求体由工作线程边收边处理）
+    if (!streams_body(conn->request) && !conn->chunked &&
+        conn->buffer.size() - conn->header_size < conn->content_length) {
+        return ParseResult::NEED_MORE;
+    }
+    return ParseResult::READY;
 }
 
-void WebDAVServer::handle_client(int client_socket) {
-    const size_t BUFFER_SIZE = 8192;  // 8KB 缓冲区
-    std::vector<char> buffer(BUFFER_SIZE);
-    std::vector<char> request_data;
+void WebDAVServer::reject_overloaded(EventLoop* loop, const std::shared_ptr<Connection>& conn) {
+    logger_->warning("Request queue full, rejecting request from " + conn->peer);
+    
+    HTTPResponse response;
+    response.status_code = 503;
+    response.status_message = "Service Unavailable";
+    response.headers["Retry-After"] = RETRY_AFTER_SECONDS;
+    response.headers["Content-Length"] = "0";
+    
+    // 请求体还有未读部分，或后面还有流水线请求时，无法继续复用连接
+    bool reusable = !conn->chunked &&
+                    conn->buffer.size() == conn->header_size + conn->content_length;
+    if (!reusable) {
+        response.headers["Connection"] = "close";
+    }
+    auto response_data = http_parser_->build_response(response);
+    
+    conn->reset();
+    if (!send_all(conn->fd, response_data.data(), response_data.size()) || !reusable ||
+        !rearm_connection(loop, conn)) {
+        close_connection(loop, conn);
+    }
+}
+
+void WebDAVServer::process_connection(EventLoop* loop, const std::shared_ptr<Connection>& conn) {
+    bool keep_alive = false;
+    
+    // 按顺序处理同一次读取中收到的多个流水线请求，响应顺序与请求一致
+    for (int served = 1; ; ++served) {
+        keep_alive = serve_request(conn);
+        if (!keep_alive) {
+            break;
+        }
+        
+        // 丢弃已处理的请求，剩余数据作为下一个请求的开头
+        conn->consume_request();
+        if (conn->buffer.empty()) {
+            break;
+        }
+        
+        ParseResult result = parse_buffered_request(conn);
+        if (result == ParseResult::FAILED) {
+            keep_alive = false;
+            break;
+        }
+        if (result == ParseResult::NEED_MORE) {
+            break;
+        }
+        
+        // 连续处理一定数量后重新排队，避免单个连接长期占用工作线程
+        if (served >= MAX_PIPELINED_PER_TURN &&
+            thread_pool_->submit([this, loop, conn]() { process_connection(loop, conn); })) {
+            return;
+        }
+    }
+    
+    conn->last_active = time(nullptr);
+    conn->busy = false;
+    
+    if (!keep_alive || !running_ || !rearm_connection(loop, conn)) {
+        close_connection(loop, conn);
+    }
+}
+
+bool WebDAVServer::read_chunked_body(const std::shared_ptr<Connection>& conn, BodyReader& reader) {
+    // 非流式方法的 chunked 请求体在工作线程中完整读入内存，上限与定长请求体相同
+    std::vector<char>& body = conn->request.body;
+    char chunk[READ_CHUNK_SIZE];
+    size_t bytes_read = 0;
+    do {
+        if (!reader.read(chunk, sizeof(chunk), bytes_read)) {
+            logger_->error("Failed to receive chunked body from " + conn->peer);
+            if (reader.timed_out()) {
+                send_error_response(conn->fd, 408, "Request Timeout");
+            } else {
+                send_error_response(conn->fd, 400, "Bad Request");
+            }
+            return false;
+        }
+        body.insert(body.end(), chunk, chunk + bytes_read);
+    } while (bytes_read > 0 && body.size() <= MAX_BUFFERED_BODY);
+    
+    if (body.size() > MAX_BUFFERED_BODY) {
+        logger_->error("Request body too large from " + conn->peer);
+        send_error_response(conn->fd, 413, "Payload Too Large");
+        return false;
+    }
+    return true;
+}
+
+bool WebDAVServer::serve_request(const std::shared_ptr<Connection>& conn) {
+    bool keep_alive = false;
     
     try {
-        while (running_) {
-            // 读取请求头
-            size_t header_end = std::string::npos;
-            while (header_end == std::string::npos) {
-                ssize_t bytes_read = recv(client_socket, buffer.data(), buffer.size(), 0);
-                if (bytes_read <= 0) {
-                    if (bytes_read == 0) {
-                        logger_->debug("Client closed connection normally");
-                    } else {
-                        logger_->error("Receive error: " + std::string(strerror(errno)));
-                    }
-                    goto cleanup;
-                }
-                
-                request_data.insert(request_data.end(), buffer.data(), buffer.data() + bytes_read);
-                std::string data(request_data.begin(), request_data.end());
-                header_end = data.find("\r\n\r\n");
+        HTTPRequest& request = conn->request;
+        const char* body = conn->buffer.data() + conn->header_size;
+        size_t buffered = std::min(conn->buffer.size() - conn->header_size, conn->content_length);
+        
+        std::unique_ptr<SocketBodyReader> body_reader;
+        std::unique_ptr<ChunkedBodyReader> chunked_reader;
+        if (conn->chunked) {
+            chunked_reader.reset(new ChunkedBodyReader(*conn, expects_continue(request)));
+            if (streams_body(request)) {
+                request.body_reader = chunked_reader.get();
+            } else if (!read_chunked_body(conn, *chunked_reader)) {
+                return false;
             }
-            
-            // 解析请求
-            HTTPRequest request;
-            if (!http_parser_->parse_request(request_data, request)) {
-                // 如果有 Content-Length，继续读取请求体
-                auto content_length_it = request.headers.find("Content-Length");
-                if (content_length_it != request.headers.end()) {
-                    size_t content_length = std::stoull(content_length_it->second);
-                    size_t headers_size = header_end + 4;  // 加上 \r\n\r\n 的长度
-                    size_t body_received = request_data.size() - headers_size;
-                    
-                    // 继续读取剩余的请求体
-                    while (body_received < content_length) {
-                        ssize_t bytes_read = recv(client_socket, buffer.data(), 
-                                                std::min(buffer.size(), content_length - body_received), 0);
-                        if (bytes_read <= 0) {
-                            if (bytes_read == 0) {
-                                logger_->debug("Client closed connection during body read");
-                            } else {
-                                logger_->error("Receive error during body read: " + std::string(strerror(errno)));
-                            }
-                            goto cleanup;
-                        }
-                        
-                        request_data.insert(request_data.end(), buffer.data(), buffer.data() + bytes_read);
-                        body_received += bytes_read;
-                        
-                        logger_->debug("Received " + std::to_string(body_received) + "/" + 
-                                     std::to_string(content_length) + " bytes of body");
-                    }
-                    
-                    // 重新解析完整的请求
-                    if (!http_parser_->parse_request(request_data, request)) {
-                        logger_->error("Failed to parse complete request");
-                        send_error_response(client_socket, 400, "Bad Request");
-                        goto cleanup;
-                    }
-                } else {
-                    logger_->error("Failed to parse request");
-                    send_error_response(client_socket, 400, "Bad Request");
-                    goto cleanup;
-                }
+        } else if (streams_body(request)) {
+            body_reader.reset(new SocketBodyReader(conn->fd, body, buffered, conn->content_length,
+                                                   expects_continue(request)));
+            request.body_reader = body_reader.get();
+        } else {
+            request.body.assign(body, body + conn->content_length);
+        }
+        
+        // 处理请求
+        HTTPResponse response;
+        handle_request(request, response);
+        request.body_reader = nullptr;
+        if (chunked_reader && chunked_reader->malformed()) {
+            logger_->error("Malformed chunked body from " + conn->peer + ": " + chunked_reader->error());
+        }
+        if ((body_reader && body_reader->timed_out()) || (chunked_reader && chunked_reader->timed_out())) {
+            logger_->warning("Request body from " + conn->peer + " arrived too slowly, closing connection");
+        }
+        
+        // 处理函数没有读完请求体时（如提前报错），剩余数据无法与下一个请求区分，只能关闭连接
+        bool body_consumed = chunked_reader ? chunked_reader->finished()
+                                            : !body_reader || body_reader->remaining() == 0;
+        bool reusable = body_consumed && wants_keep_alive(request);
+        
+        // 长度未知的响应体：HTTP/1.1 用 chunked 编码，HTTP/1.0 只能以关闭连接表示结束
+        if (response.body_producer) {
+            if (request.version == "HTTP/1.0") {
+                reusable = false;
+            } else {
+                response.headers["Transfer-Encoding"] = "chunked";
             }
-            
-            // 处理请求
-            HTTPResponse response;
-            handle_request(request, response);
-            
-            // 发送响应
-            auto response_data = http_parser_->build_response(response);
-            send(client_socket, response_data.data(), response_data.size(), 0);
-            
-            // 清空请求数据，准备下一个请求
-            request_data.clear();
         }
+        if (!reusable) {
+            response.headers["Connection"] = "close";
+        }
+        
+        // 发送响应
+        keep_alive = send_response(conn->fd, response) && reusable;
     } catch (const std::exception& e) {
-        logger_->error("Exception in client thread: " + std::string(e.what()));
+        logger_->error("Exception in worker thread: " + std::string(e.what()));
     } catch (...) {
-        logger_->error("Unknown exception in client thread");
+        logger_->error("Unknown exception in worker thread");
     }
     
-cleanup:
-    close(client_socket);
+    return keep_alive;
+}
+
+bool WebDAVServer::rearm_connection(EventLoop* loop, const std::shared_ptr<Connection>& conn) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = CLIENT_EVENTS;
+    ev.data.fd = conn->fd;
+    if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev) < 0) {
+        logger_->error("Failed to rearm client socket: " + std::string(strerror(errno)));
+        return false;
+    }
+    return true;
+}
+
+void WebDAVServer::close_connection(EventLoop* loop, const std::shared_ptr<Connection>& conn) {
+    // 只有仍在表中的连接才关闭，避免误关已被复用的 fd
+    {
+        std::lock_guard<std::mutex> lock(loop->connections_mutex);
+        auto it = loop->connections.find(conn->fd);
+        if (it == loop->connections.end() || it->second != conn) {
+            return;
+        }
+        loop->connections.erase(it);
+    }
+    
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, conn->fd, nullptr);
+    close(conn->fd);
     logger_->debug("Client socket closed");
 }
 
+void WebDAVServer::close_idle_connections(EventLoop* loop) {
+    std::vector<std::shared_ptr<Connection>> idle;
+    time_t now = time(nullptr);
+    {
+        std::lock_guard<std::mutex> lock(loop->connections_mutex);
+        for (const auto& entry : loop->connections) {
+            const std::shared_ptr<Connection>& conn = entry.second;
+            if (!conn->busy && now - conn->last_active >= KEEP_ALIVE_TIMEOUT) {
+                idle.push_back(conn);
+            }
+        }
+    }
+    
+    for (const auto& conn : idle) {
+        logger_->debug("Closing idle connection from " + conn->peer);
+        close_connection(loop, conn);
+    }
+}
+
+ThreadPool::Stats WebDAVServer::get_worker_stats() {
+    if (!thread_pool_) {
+        ThreadPool::Stats stats = ThreadPool::Stats();
+        stats.queue_capacity = config_.max_queued_requests;
+        return stats;
+    }
+    return thread_pool_->get_stats();
+}
+
+void WebDAVServer::log_worker_stats() {
+    ThreadPool::Stats stats = get_worker_stats();
+    logger_->info("Worker pool: queue " + std::to_string(stats.queue_depth) + "/" +
+                  std::to_string(stats.queue_capacity) +
+                  ", active " + std::to_string(stats.active) + "/" + std::to_string(stats.threads) +
+                  ", completed " + std::to_string(stats.completed) +
+                  ", rejected " + std::to_string(stats.rejected) +
+                  ", avg wait " + std::to_string(stats.avg_wait_us) + "us" +
+                  ", max wait " + std::to_string(stats.max_wait_us) + "us");
+    
+    FileManager::CacheStats cache = file_manager_->get_cache_stats();
+    auto describe = [](const LruCacheStats& s) {
+        uint64_t lookups = s.hits + s.misses;
+        return std::to_string(s.entries) + " entries, " + std::to_string(s.bytes / 1024) + "/" +
+               std::to_string(s.capacity / 1024) + " KiB, hit rate " +
+               std::to_string(lookups ? s.hits * 100 / lookups : 0) + "% of " + std::to_string(lookups) +
+               ", evicted " + std::to_string(s.evictions);
+    };
+    logger_->info("Metadata cache: " + describe(cache.info) + "; listing cache: " + describe(cache.listing) +
+                  "; negative cache: " + describe(cache.missing));
+}
+
+bool WebDAVServer::send_response(int socket_fd, HTTPResponse& response) {
+    std::string header = http_parser_->build_response_header(response);
+    bool ok;
+    
+    if (response.file_fd >= 0) {
+        // 头部和分段头先用 MSG_MORE 暂存，与文件内容一起发出
+        ok = send_all(socket_fd, header.data(), header.size(), MSG_MORE);
+        for (size_t i = 0; ok && i < response.file_segments.size(); ++i) {
+            const FileSegment& segment = response.file_segments[i];
+            ok = (segment.prefix.empty() ||
+                  send_all(socket_fd, segment.prefix.data(), segment.prefix.size(), MSG_MORE)) &&
+                 send_file(socket_fd, response.file_fd, segment.offset, segment.length);
+        }
+        if (ok && !response.file_trailer.empty()) {
+            ok = send_all(socket_fd, response.file_trailer.data(), response.file_trailer.size());
+        }
+        close(response.file_fd);
+        response.file_fd = -1;
+    } else if (response.body_producer) {
+        // 生产者的输出先用 MSG_MORE 暂存，最后一段去掉该标志把剩余数据推出
+        int flags = MSG_MORE;
+        BodyWriter output = [this, socket_fd, &flags](const char* data, size_t size) {
+            return send_all(socket_fd, data, size, flags);
+        };
+        ok = send_all(socket_fd, header.data(), header.size(), MSG_MORE);
+        if (response.headers.count("Transfer-Encoding")) {
+            ChunkedEncoder encoder(output);
+            ok = ok && response.body_producer([&encoder](const char* data, size_t size) {
+                return encoder.write(data, size);
+            });
+            flags = 0;
+            ok = ok && encoder.finish();
+        } else {
+            // 以关闭连接结束的响应体，关闭 socket 时暂存的数据会被推出
+            ok = ok && response.body_producer(output);
+        }
+    } else if (response.body.empty()) {
+        ok = send_all(socket_fd, header.data(), header.size());
+    } else {
+        ok = send_all(socket_fd, header.data(), header.size(), MSG_MORE) &&
+             send_all(socket_fd, response.body.data(), response.body.size());
+    }
+    
+    return ok;
+}
+
+bool WebDAVServer::send_all(int socket_fd, const char* data, size_t size, int flags) {
+    size_t sent = 0;
+    while (sent < size) {
+        ssize_t n = send(socket_fd, data + sent, size - sent, flags | MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (wait_writable(socket_fd)) {
+                continue;
+            }
+            logger_->error("Send timeout");
+            return false;
+        }
+        logger_->error("Send error: " + std::string(strerror(errno)));
+        return false;
+    }
+    return true;
+}
+
+bool WebDAVServer::send_file(int socket_fd, int file_fd, size_t offset, size_t length) {
+    off_t pos = static_cast<off_t>(offset);
+    size_t remaining = length;
+    while (remaining > 0) {
+        ssize_t n = sendfile(socket_fd, file_fd, &pos, std::min(remaining, SENDFILE_CHUNK_SIZE));
+        if (n > 0) {
+            remaining -= n;
+            continue;
+        }
+        if (n == 0) {
+            logger_->error("File truncated while sending, " + std::to_string(remaining) +
+                           " bytes missing");
+            return false;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            if (wait_writable(socket_fd)) {
+                continue;
+            }
+            logger_->error("Send timeout");
+            return false;
+        }
+        logger_->error("sendfile error: " + std::string(strerror(errno)));
+        return false;
+    }
+    return true;
+}
+
 void WebDAVServer::handle_request(const HTTPRequest& request, HTTPResponse& response) {
     logger_->info("Handling request: " + std::to_string(static_cast<int>(request.method)) + 
                  " for URI: " + request.uri);
@@ -370,58 +1129,13 @@ std::string WebDAVServer::format_http_date(time_t t) {
     return std::string(buf);
 }
 
-std::string WebDAVServer::format_iso_date(time_t t) {
-    char buf[100];
-    struct tm* tm = gmtime(&t);
-    strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", tm);
-    return std::string(buf);
-}
-
-std::string WebDAVServer::build_xml_response(const std::string& uri, const FileInfo& info) {
-    std::stringstream ss;
-    ss << "  <D:response>\n"
-       << "    <D:href>" << uri << "</D:href>\n"
-       << "    <D:propstat>\n"
-       << "      <D:prop>\n"
-       << "        <D:resourcetype>";
-    
-    if (info.is_directory) {
-        ss << "<D:collection/>";
-    }
-    
-    ss << "</D:resourcetype>\n"
-       << "        <D:getcontentlength>" << info.size << "</D:getcontentlength>\n"
-       << "        <D:getlastmodified>" << format_http_date(info.modified_time) << "</D:getlastmodified>\n"
-       << "        <D:creationdate>" << format_iso_date(info.created_time) << "</D:creationdate>\n"
-       << "        <D:getetag>" << info.etag << "</D:getetag>\n"
-       << "        <D:getcontenttype>" << MimeTypes::get_mime_type(info.name) << "</D:getcontenttype>\n"
-       << "        <D:displayname>" << info.name << "</D:displayname>\n"
-       << "        <D:supportedlock>\n"
-       << "          <D:lockentry>\n"
-       << "            <D:lockscope><D:exclusive/></D:lockscope>\n"
-       << "            <D:locktype><D:write/></D:locktype>\n"
-       << "          </D:lockentry>\n"
-       << "        </D:supportedlock>\n";
-    
-    for (const auto& prop : info.properties) {
-        ss << "        <" << prop.first << ">" << prop.second << "</" << prop.first << ">\n";
-    }
-    
-    ss << "      </D:prop>\n"
-       << "      <D:status>HTTP/1.1 200 OK</D:status>\n"
-       << "    </D:propstat>\n"
-       << "  </D:response>\n";
-    
-    return ss.str();
-}
-
 void WebDAVServer::send_error_response(int client_socket, int status_code, const std::string& status_message) {
     HTTPResponse response;
     response.status_code = status_code;
     response.status_message = status_message;
     response.headers["Content-Length"] = "0";
     auto response_data = http_parser_->build_response(response);
-    send(client_socket, response_data.data(), response_data.size(), 0);
+    send_all(client_socket, response_data.data(), response_data.size());
 }
 
 void WebDAVServer::handle_lock_request(int client_socket) {
@@ -432,7 +1146,7 @@ void WebDAVServer::handle_lock_request(int client_socket) {
         "Content-Length: 0\r\n"
         "\r\n";
     
-    send(client_socket, response.data(), response.size(), 0);
+    send_all(client_socket, response.data(), response.size());
 }
 
 } // namespace webdav 
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "test_support.h"
+#include "byte_range.h"
+
+#include <string>
+#include <vector>
+
+using namespace webdav;
+
+namespace {
+
+std::vector<ByteRange> parse(const std::string& value, size_t file_size, RangeResult expected) {
+    std::vector<ByteRange> ranges;
+    CHECK(parse_range_header(value, file_size, ranges) == expected);
+    return ranges;
+}
+
+bool equals(const std::vector<ByteRange>& ranges, const std::vector<ByteRange>& expected) {
+    return ranges == expected;
+}
+
+} // namespace
+
+TEST(single_ranges) {
+    CHECK(equals(parse("bytes=0-99", 1000, RangeResult::SATISFIABLE), {ByteRange(0, 99)}));
+    CHECK(equals(parse("bytes=900-", 1000, RangeResult::SATISFIABLE), {ByteRange(900, 999)}));
+    // 末尾超出文件时截到最后一个字节
+    CHECK(equals(parse("bytes=990-5000", 1000, RangeResult::SATISFIABLE), {ByteRange(990, 999)}));
+    CHECK(equals(parse("bytes=999-999", 1000, RangeResult::SATISFIABLE), {ByteRange(999, 999)}));
+}
+
+TEST(suffix_ranges) {
+    CHECK(equals(parse("bytes=-100", 1000, RangeResult::SATISFIABLE), {ByteRange(900, 999)}));
+    CHECK(equals(parse("bytes=-1", 1000, RangeResult::SATISFIABLE), {ByteRange(999, 999)}));
+    // 后缀比文件长时返回整个文件
+    CHECK(equals(parse("bytes=-5000", 1000, RangeResult::SATISFIABLE), {ByteRange(0, 999)}));
+    // 长度为 0 的后缀不可满足；空文件上的后缀范围也不可满足
+    parse("bytes=-0", 1000, RangeResult::UNSATISFIABLE);
+    parse("bytes=-10", 0, RangeResult::UNSATISFIABLE);
+}
+
+// 多个范围按起点排序，重叠和相邻的区间合并
+TEST(overlapping_ranges) {
+    CHECK(equals(parse("bytes=500-599,0-99", 1000, RangeResult::SATISFIABLE),
+                 {ByteRange(0, 99), ByteRange(500, 599)}));
+    CHECK(equals(parse("bytes=0-99,50-149", 1000, RangeResult::SATISFIABLE), {ByteRange(0, 149)}));
+    CHECK(equals(parse("bytes=0-99,100-199", 1000, RangeResult::SATISFIABLE), {ByteRange(0, 199)}));
+    CHECK(equals(parse("bytes=0-99,101-199", 1000, RangeResult::SATISFIABLE),
+                 {ByteRange(0, 99), ByteRange(101, 199)}));
+    CHECK(equals(parse("bytes=10-20,0-999", 1000, RangeResult::SATISFIABLE), {ByteRange(0, 999)}));
+    // 后缀范围与普通范围重叠
+    CHECK(equals(parse("bytes=850-949, -100", 1000, RangeResult::SATISFIABLE), {ByteRange(850, 999)}));
+    CHECK(equals(parse("bytes=0-0,-1,500-", 1000, RangeResult::SATISFIABLE),
+                 {ByteRange(0, 0), ByteRange(500, 999)}));
+}
+
+// 超出文件的范围被丢弃；全部超出时不可满足
+TEST(unsatisfiable_ranges) {
+    CHECK(equals(parse("bytes=0-9,2000-3000", 1000, RangeResult::SATISFIABLE), {ByteRange(0, 9)}));
+    parse("bytes=1000-", 1000, RangeResult::UNSATISFIABLE);
+    parse("bytes=1000-1100,5000-", 1000, RangeResult::UNSATISFIABLE);
+    parse("bytes=0-", 0, RangeResult::UNSATISFIABLE);
+}
+
+// 无法识别的 Range 整个忽略，返回完整文件
+TEST(ignored_ranges) {
+    const char* values[] = {
+        "",
+        "items=0-9",
+        "bytes=",
+        "bytes= , ",
+        "bytes=5",
+        "bytes=9-5",
+        "bytes=a-b",
+        "bytes=0-9,x",
+        "bytes=-",
+        "bytes=+1-2",
+        "bytes=0-99999999999999999999999"
+    };
+    for (const char* value : values) {
+        parse(value, 1000, RangeResult::IGNORE);
+    }
+
+    // 范围过多
+    std::string many = "bytes=0-0";
+    for (int i = 1; i <= 32; ++i) {
+        many += "," + std::to_string(i * 2) + "-" + std::to_string(i * 2);
+    }
+    parse(many, 1000, RangeResult::IGNORE);
+}
+
+TEST(parse_size_values) {
+    size_t value = 0;
+    CHECK(parse_size("0", value) && value == 0);
+    CHECK(parse_size("18446744073709551615", value) && value == 18446744073709551615ULL);
+    CHECK(!parse_size("18446744073709551616", value));
+    CHECK(!parse_size("", value));
+    CHECK(!parse_size("-1", value));
+    CHECK(!parse_size(" 1", value));
+    CHECK(!parse_size("1e3", value));
+}
+
+TEST(content_range_header) {
+    CHECK(content_range(ByteRange(0, 99), 1000) == "bytes 0-99/1000");
+    CHECK(content_range(ByteRange(999, 999), 1000) == "bytes 999-999/1000");
+}
@@ -0,0 +1,161 @@
+#include "test_support.h"
+#include "chunked.h"
+
+#include <algorithm>
+#include <string>
+
+using namespace webdav;
+
+namespace {
+
+// 以 input_step 字节为单位送入输入、每次最多取 output_step 字节输出，直到结束或出错
+ChunkedDecoder::Status decode_all(const std::string& input, size_t input_step, size_t output_step,
+                                  std::string& body, size_t& consumed_total) {
+    ChunkedDecoder decoder;
+    std::string output(output_step, '\0');
+    body.clear();
+    consumed_total = 0;
+    size_t available = 0;
+    while (true) {
+        available = std::min(input.size(), std::max(available, consumed_total) + input_step);
+        size_t consumed = 0;
+        size_t produced = 0;
+        ChunkedDecoder::Status status = decoder.decode(input.data() + consumed_total, available - consumed_total,
+                                                       consumed, &output[0], output.size(), produced);
+        consumed_total += consumed;
+        body.append(output.data(), produced);
+        if (status != ChunkedDecoder::Status::OK) {
+            return status;
+        }
+        if (consumed == 0 && produced == 0 && available == input.size()) {
+            return status;   // 输入已全部送入但请求体尚未结束
+        }
+    }
+}
+
+ChunkedDecoder::Status decode_all(const std::string& input, std::string& body) {
+    size_t consumed = 0;
+    return decode_all(input, input.size(), 64 * 1024, body, consumed);
+}
+
+const std::string ENCODED =
+    "5\r\nhello\r\n"
+    "1;name=value\r\n \r\n"
+    "A\r\n0123456789\r\n"
+    "0\r\n"
+    "Checksum: abc\r\n"
+    "X-Trailer: 1\r\n"
+    "\r\n";
+const std::string DECODED = "hello 0123456789";
+
+} // namespace
+
+TEST(decodes_extensions_and_trailers) {
+    std::string body;
+    CHECK(decode_all(ENCODED, body) == ChunkedDecoder::Status::DONE);
+    CHECK(body == DECODED);
+}
+
+// 输入在任意位置切开、输出缓冲区只有一个字节时结果不变
+TEST(split_input_and_small_output) {
+    for (size_t step = 1; step <= ENCODED.size(); ++step) {
+        std::string body;
+        size_t consumed = 0;
+        CHECK(decode_all(ENCODED, step, 1, body, consumed) == ChunkedDecoder::Status::DONE);
+        CHECK(body == DECODED);
+        CHECK(consumed == ENCODED.size());
+    }
+}
+
+// 结束块之后的数据属于下一个流水线请求，不被消费
+TEST(stops_after_last_chunk) {
+    std::string input = "3\r\nabc\r\n0\r\n\r\nGET / HTTP/1.1\r\n";
+    std::string body;
+    size_t consumed = 0;
+    CHECK(decode_all(input, input.size(), 16, body, consumed) == ChunkedDecoder::Status::DONE);
+    CHECK(body == "abc");
+    CHECK(input.substr(consumed) == "GET / HTTP/1.1\r\n");
+}
+
+TEST(malformed_chunk_sizes) {
+    const char* inputs[] = {
+        "\r\n",                          // 缺少块大小
+        "g\r\nabc\r\n0\r\n\r\n",
+        "-1\r\n",
+        "0x3\r\nabc\r\n0\r\n\r\n",
+        " 3\r\nabc\r\n0\r\n\r\n",
+        "3\nabc\r\n0\r\n\r\n",           // 块大小行只有 LF
+        "3\r\rabc\r\n0\r\n\r\n",
+        "10000000000000000\r\n",         // 超出 size_t
+        "3\r\nabcd\r\n0\r\n\r\n",        // 数据比声明的长
+        "3\r\nabc\n0\r\n\r\n"
+    };
+    for (const char* input : inputs) {
+        std::string body;
+        CHECK(decode_all(input, body) == ChunkedDecoder::Status::ERROR);
+    }
+}
+
+TEST(malformed_trailers) {
+    std::string body;
+    CHECK(decode_all("0\r\nX: 1\r\r\n\r\n", body) == ChunkedDecoder::Status::ERROR);
+    CHECK(decode_all("0\r\n\r\r", body) == ChunkedDecoder::Status::ERROR);
+
+    // 单行和总长度都有上限
+    std::string long_line = "0\r\nX: " + std::string(5000, 'a') + "\r\n\r\n";
+    CHECK(decode_all(long_line, body) == ChunkedDecoder::Status::ERROR);
+    std::string many_lines = "0\r\n";
+    for (int i = 0; i < 20; ++i) {
+        many_lines += "X: " + std::string(1000, 'a') + "\r\n";
+    }
+    many_lines += "\r\n";
+    CHECK(decode_all(many_lines, body) == ChunkedDecoder::Status::ERROR);
+
+    std::string long_extension = "1;" + std::string(5000, 'e') + "\r\na\r\n0\r\n\r\n";
+    CHECK(decode_all(long_extension, body) == ChunkedDecoder::Status::ERROR);
+}
+
+// 未结束的请求体不算完成
+TEST(truncated_body) {
+    std::string body;
+    CHECK(decode_all("5\r\nhel", body) == ChunkedDecoder::Status::OK);
+    CHECK(decode_all("0\r\n", body) == ChunkedDecoder::Status::OK);
+}
+
+// 出错后继续调用仍然返回错误
+TEST(error_is_sticky) {
+    ChunkedDecoder decoder;
+    char output[16];
+    size_t consumed = 0;
+    size_t produced = 0;
+    CHECK(decoder.decode("z", 1, consumed, output, sizeof(output), produced) == ChunkedDecoder::Status::ERROR);
+    CHECK(!decoder.error().empty());
+    CHECK(decoder.decode("0\r\n\r\n", 5, consumed, output, sizeof(output), produced) ==
+          ChunkedDecoder::Status::ERROR);
+    CHECK(consumed == 0);
+
+    decoder.reset();
+    CHECK(decoder.decode("0\r\n\r\n", 5, consumed, output, sizeof(output), produced) ==
+          ChunkedDecoder::Status::DONE);
+}
+
+// 编码器的输出能被解码器还原
+TEST(encoder_round_trip) {
+    std::string encoded;
+    ChunkedEncoder encoder([&encoded](const char* data, size_t size) {
+        encoded.append(data, size);
+        return true;
+    }, 7);
+    std::string original;
+    for (int i = 0; i < 100; ++i) {
+        original += std::to_string(i);
+    }
+    CHECK(encoder.write(original.data(), 10));
+    CHECK(encoder.write(original.data() + 10, original.size() - 10));
+    CHECK(encoder.finish());
+
+    std::string body;
+    CHECK(decode_all(encoded, body) == ChunkedDecoder::Status::DONE);
+    CHECK(body == original);
+    CHECK(encoded.compare(0, 3, "7\r\n") == 0);
+}
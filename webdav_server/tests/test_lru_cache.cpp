@@ -0,0 +1,166 @@
+#include "test_support.h"
+#include "lru_cache.h"
+
+#include <string>
+
+using namespace webdav;
+
+namespace {
+
+typedef ShardedLruCache<std::string> Cache;
+
+// 定长的键，使每个条目的固定开销相同
+std::string key(int i) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "/k%04d", i);
+    return buf;
+}
+
+// 一个条目（键长同 key()、值估计为 value_bytes）在缓存中计入的字节数
+size_t entry_cost(size_t value_bytes) {
+    Cache probe(1 << 20, 1);
+    probe.put(key(0), "v", value_bytes);
+    return probe.get_stats().bytes;
+}
+
+bool contains(Cache& cache, const std::string& k) {
+    std::string value;
+    return cache.get(k, value);
+}
+
+} // namespace
+
+// 超出预算时按最久未用的顺序淘汰，占用始终不超过预算
+TEST(evicts_oldest_within_budget) {
+    const size_t cost = entry_cost(100);
+    Cache cache(4 * cost, 1);
+    for (int i = 0; i < 10; ++i) {
+        cache.put(key(i), "v", 100);
+        CHECK(cache.get_stats().bytes <= 4 * cost);
+    }
+    LruCacheStats stats = cache.get_stats();
+    CHECK(stats.entries == 4);
+    CHECK(stats.bytes == 4 * cost);
+    CHECK(stats.evictions == 6);
+    for (int i = 0; i < 6; ++i) {
+        CHECK(!contains(cache, key(i)));
+    }
+    for (int i = 6; i < 10; ++i) {
+        CHECK(contains(cache, key(i)));
+    }
+}
+
+// 命中的条目变为最近使用，下一次淘汰跳过它
+TEST(get_refreshes_recency) {
+    const size_t cost = entry_cost(100);
+    Cache cache(3 * cost, 1);
+    cache.put(key(0), "v", 100);
+    cache.put(key(1), "v", 100);
+    cache.put(key(2), "v", 100);
+    CHECK(contains(cache, key(0)));
+    cache.put(key(3), "v", 100);
+    CHECK(contains(cache, key(0)));
+    CHECK(!contains(cache, key(1)));
+    CHECK(contains(cache, key(2)));
+    CHECK(contains(cache, key(3)));
+}
+
+// 一个大条目挤掉多个小条目
+TEST(large_entry_evicts_several) {
+    const size_t small = entry_cost(10);
+    const size_t large = entry_cost(10 + 3 * small);
+    Cache cache(large + small, 1);
+    for (int i = 0; i < 4; ++i) {
+        cache.put(key(i), "v", 10);
+    }
+    CHECK(cache.get_stats().entries == 4);
+    cache.put(key(9), "big", 10 + 3 * small);
+    LruCacheStats stats = cache.get_stats();
+    CHECK(stats.bytes <= large + small);
+    CHECK(contains(cache, key(9)));
+    CHECK(contains(cache, key(3)));
+    CHECK(!contains(cache, key(0)));
+    CHECK(stats.entries == 2);
+}
+
+// 超过分片预算的条目不缓存，也不挤掉已有条目；同名的旧值随之删除
+TEST(oversized_entry_not_cached) {
+    const size_t cost = entry_cost(100);
+    Cache cache(2 * cost, 1);
+    cache.put(key(0), "v", 100);
+    cache.put(key(1), "v", 100);
+    cache.put(key(2), "huge", 10 * cost);
+    CHECK(!contains(cache, key(2)));
+    CHECK(contains(cache, key(0)));
+    CHECK(contains(cache, key(1)));
+    CHECK(cache.get_stats().evictions == 0);
+
+    cache.put(key(0), "huge", 10 * cost);
+    CHECK(!contains(cache, key(0)));
+    CHECK(cache.get_stats().bytes == cost);
+}
+
+// 替换已有条目时旧条目的字节数被扣除，不会重复计算
+TEST(replace_updates_accounting) {
+    const size_t cost = entry_cost(100);
+    Cache cache(10 * cost, 1);
+    for (int i = 0; i < 5; ++i) {
+        cache.put(key(0), "v" + std::to_string(i), 100);
+    }
+    LruCacheStats stats = cache.get_stats();
+    CHECK(stats.entries == 1);
+    CHECK(stats.bytes == cost);
+    CHECK(stats.evictions == 0);
+    std::string value;
+    CHECK(cache.get(key(0), value) && value == "v4");
+
+    cache.put(key(0), "small", 0);
+    CHECK(cache.get_stats().bytes == entry_cost(0));
+}
+
+// 多个分片时每个分片各自守住预算，总占用不超过总容量
+TEST(sharded_budget) {
+    const size_t cost = entry_cost(200);
+    Cache cache(16 * 8 * cost, 16);
+    for (int i = 0; i < 5000; ++i) {
+        cache.put(key(i), "v", 200);
+    }
+    LruCacheStats stats = cache.get_stats();
+    CHECK(stats.bytes <= stats.capacity);
+    CHECK(stats.entries <= 16 * 8);
+    CHECK(stats.entries + stats.evictions == 5000);
+    CHECK(contains(cache, key(4999)));
+}
+
+// 删除子树不影响名称相同前缀的兄弟路径，字节数随之扣除
+TEST(erase_tree_and_clear) {
+    Cache cache(1 << 20, 4);
+    cache.put("/a", "v", 10);
+    cache.put("/a/b", "v", 10);
+    cache.put("/a/b/c", "v", 10);
+    cache.put("/a-b", "v", 10);
+    cache.put("/ab", "v", 10);
+    cache.erase_tree("/a");
+    CHECK(!contains(cache, "/a"));
+    CHECK(!contains(cache, "/a/b"));
+    CHECK(!contains(cache, "/a/b/c"));
+    CHECK(contains(cache, "/a-b"));
+    CHECK(contains(cache, "/ab"));
+    CHECK(cache.get_stats().entries == 2);
+
+    cache.clear();
+    LruCacheStats stats = cache.get_stats();
+    CHECK(stats.entries == 0);
+    CHECK(stats.bytes == 0);
+}
+
+// 记下 generation 之后发生过失效时 put_if_current 不写入
+TEST(put_if_current_after_invalidation) {
+    Cache cache(1 << 20, 1);
+    uint64_t generation = cache.generation();
+    CHECK(cache.put_if_current("/x", "v", 10, generation));
+    generation = cache.generation();
+    cache.erase("/y");
+    CHECK(!cache.put_if_current("/z", "v", 10, generation));
+    CHECK(!contains(cache, "/z"));
+}
@@ -0,0 +1,11 @@
+#include "test_support.h"
+
+int main() {
+    using namespace webdav::test;
+    for (const TestCase& test_case : registry()) {
+        int before = failures();
+        test_case.run();
+        std::printf("%s %s\n", failures() == before ? "PASS" : "FAIL", test_case.name);
+    }
+    return failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+#include "test_support.h"
+#include "multistatus_writer.h"
+
+#include <ctime>
+#include <string>
+
+using namespace webdav;
+
+namespace {
+
+const time_t DAY = 86400;
+
+// 只请求两个日期属性，取出生成的 getlastmodified 和 creationdate 文本
+void format_dates(time_t t, std::string& http_date, std::string& iso_date) {
+    FileInfo info;
+    info.name = "file";
+    info.size = 0;
+    info.created_time = t;
+    info.modified_time = t;
+    info.accessed_time = t;
+    info.is_directory = false;
+
+    PropfindRequest request;
+    request.mode = PropfindRequest::PROP;
+    request.live_props = PROP_GETLASTMODIFIED | PROP_CREATIONDATE;
+
+    MultistatusWriter writer;
+    writer.add_response("/", "file", info, request);
+    std::string xml(writer.data(), writer.size());
+
+    const std::string modified_tag = "<D:getlastmodified>";
+    size_t begin = xml.find(modified_tag) + modified_tag.size();
+    http_date = xml.substr(begin, xml.find("</D:getlastmodified>") - begin);
+    const std::string created_tag = "<D:creationdate>";
+    begin = xml.find(created_tag) + created_tag.size();
+    iso_date = xml.substr(begin, xml.find("</D:creationdate>") - begin);
+}
+
+// 参照实现：gmtime_r + strftime（C locale 下的英文星期和月份）
+std::string reference(time_t t, const char* format) {
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    char buf[64];
+    strftime(buf, sizeof(buf), format, &tm);
+    return buf;
+}
+
+time_t utc(int year, int month, int day, int hour = 0, int minute = 0, int second = 0) {
+    struct tm tm = {};
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = day;
+    tm.tm_hour = hour;
+    tm.tm_min = minute;
+    tm.tm_sec = second;
+    return timegm(&tm);
+}
+
+bool matches_reference(time_t t) {
+    std::string http_date;
+    std::string iso_date;
+    format_dates(t, http_date, iso_date);
+    bool ok = http_date == reference(t, "%a, %d %b %Y %H:%M:%S GMT") &&
+              iso_date == reference(t, "%Y-%m-%dT%H:%M:%SZ");
+    if (!ok) {
+        std::fprintf(stderr, "t=%lld: %s / %s\n", static_cast<long long>(t), http_date.c_str(), iso_date.c_str());
+    }
+    return ok;
+}
+
+} // namespace
+
+TEST(known_dates) {
+    std::string http_date;
+    std::string iso_date;
+    format_dates(784111777, http_date, iso_date);
+    CHECK(http_date == "Sun, 06 Nov 1994 08:49:37 GMT");
+    CHECK(iso_date == "1994-11-06T08:49:37Z");
+
+    format_dates(0, http_date, iso_date);
+    CHECK(http_date == "Thu, 01 Jan 1970 00:00:00 GMT");
+
+    format_dates(utc(2024, 2, 29, 23, 59, 59), http_date, iso_date);
+    CHECK(http_date == "Thu, 29 Feb 2024 23:59:59 GMT");
+    CHECK(iso_date == "2024-02-29T23:59:59Z");
+}
+
+// 2 月底到 3 月初的每一秒边界：普通闰年、百年不闰（1900、2100）、四百年闰（2000）
+TEST(leap_year_boundaries) {
+    const int years[] = {1900, 1904, 1969, 1970, 1972, 1999, 2000, 2001, 2023, 2024, 2038, 2100, 2104, 2400};
+    for (int year : years) {
+        time_t start = utc(year, 2, 27);
+        for (time_t t = start; t < start + 4 * DAY; t += 3600) {
+            CHECK(matches_reference(t));
+        }
+        CHECK(matches_reference(utc(year, 3, 1) - 1));
+        CHECK(matches_reference(utc(year, 3, 1)));
+        CHECK(matches_reference(utc(year, 12, 31, 23, 59, 59)));
+        CHECK(matches_reference(utc(year + 1, 1, 1)));
+    }
+
+    std::string http_date;
+    std::string iso_date;
+    format_dates(utc(2100, 3, 1) - 1, http_date, iso_date);
+    CHECK(iso_date == "2100-02-28T23:59:59Z");
+    format_dates(utc(2000, 3, 1) - 1, http_date, iso_date);
+    CHECK(iso_date == "2000-02-29T23:59:59Z");
+}
+
+// 1970 年之前（负的 time_t）和之后的每一天都与参照实现一致
+TEST(every_day_1900_to_2200) {
+    for (time_t t = utc(1900, 1, 1, 12, 34, 56); t < utc(2200, 1, 1); t += DAY) {
+        if (!matches_reference(t)) {
+            CHECK(false);
+            break;
+        }
+    }
+}
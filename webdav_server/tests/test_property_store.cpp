@@ -0,0 +1,208 @@
+#include "test_support.h"
+#include "property_store.h"
+#include "logger.h"
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace webdav;
+using webdav::test::TempDir;
+
+namespace {
+
+Logger& test_logger() {
+    static Logger logger("/dev/null", Logger::Level::ERROR);
+    return logger;
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void write_file(const std::string& path, const std::string& data) {
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    out.write(data.data(), data.size());
+}
+
+size_t file_size(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+}
+
+PropertyStore::PropertyMap props(const std::string& name, const std::string& value) {
+    PropertyStore::PropertyMap map;
+    map[name] = value;
+    return map;
+}
+
+std::string get(PropertyStore& store, const std::string& path, const std::string& name) {
+    PropertyStore::PropertyMap map;
+    if (!store.get(path, map) || !map.count(name)) {
+        return "<missing>";
+    }
+    return map[name];
+}
+
+const std::vector<std::string> NO_REMOVALS;
+
+} // namespace
+
+TEST(replays_all_record_types) {
+    TempDir dir;
+    std::string log = dir.file("props.log");
+    {
+        PropertyStore store(test_logger());
+        CHECK(store.open(log));
+        CHECK(store.update("/a", props("{ns:}color", "red"), NO_REMOVALS));
+        CHECK(store.update("/a", props("{ns:}size", "big"), std::vector<std::string>(1, "{ns:}color")));
+        CHECK(store.update("/dir/x", props("{ns:}k", "1"), NO_REMOVALS));
+        CHECK(store.update("/dir/sub/y", props("{ns:}k", "2"), NO_REMOVALS));
+        CHECK(store.update("/dir-x", props("{ns:}k", "3"), NO_REMOVALS));
+        CHECK(store.copy("/a", "/b"));
+        CHECK(store.move_tree("/dir", "/moved"));
+        CHECK(store.remove_tree("/moved/sub"));
+    }
+
+    PropertyStore store(test_logger());
+    CHECK(store.open(log));
+    CHECK(get(store, "/a", "{ns:}color") == "<missing>");
+    CHECK(get(store, "/a", "{ns:}size") == "big");
+    CHECK(get(store, "/b", "{ns:}size") == "big");
+    CHECK(get(store, "/dir/x", "{ns:}k") == "<missing>");
+    CHECK(get(store, "/moved/x", "{ns:}k") == "1");
+    CHECK(get(store, "/moved/sub/y", "{ns:}k") == "<missing>");
+    // 名称以 "/dir" 开头的兄弟路径不属于 /dir 子树
+    CHECK(get(store, "/dir-x", "{ns:}k") == "3");
+}
+
+// 最后一条记录在任意字节处被截断（写入中途崩溃）：之前的记录全部保留，
+// 残缺部分被截掉，之后追加的记录在下次打开时能正常重放
+TEST(torn_tail_at_every_offset) {
+    TempDir dir;
+    std::string log = dir.file("props.log");
+    size_t committed = 0;
+    {
+        PropertyStore store(test_logger());
+        CHECK(store.open(log));
+        CHECK(store.update("/a", props("{ns:}v", "1"), NO_REMOVALS));
+        CHECK(store.update("/b", props("{ns:}v", "2"), NO_REMOVALS));
+        committed = file_size(log);
+        CHECK(store.update("/a", props("{ns:}v", "torn"), NO_REMOVALS));
+    }
+    std::string full = read_file(log);
+    CHECK(full.size() > committed);
+
+    for (size_t cut = committed; cut < full.size(); ++cut) {
+        write_file(log, full.substr(0, cut));
+        {
+            PropertyStore store(test_logger());
+            CHECK(store.open(log));
+            CHECK(get(store, "/a", "{ns:}v") == "1");
+            CHECK(get(store, "/b", "{ns:}v") == "2");
+            CHECK(file_size(log) == committed);
+            CHECK(store.update("/c", props("{ns:}v", "3"), NO_REMOVALS));
+        }
+        PropertyStore store(test_logger());
+        CHECK(store.open(log));
+        CHECK(get(store, "/a", "{ns:}v") == "1");
+        CHECK(get(store, "/c", "{ns:}v") == "3");
+    }
+
+    // 完整的日志重放出最后一条记录
+    write_file(log, full);
+    PropertyStore store(test_logger());
+    CHECK(store.open(log));
+    CHECK(get(store, "/a", "{ns:}v") == "torn");
+}
+
+// 末尾记录内容损坏（CRC 不符）或追加了垃圾数据时，从该处截断
+TEST(corrupt_tail) {
+    TempDir dir;
+    std::string log = dir.file("props.log");
+    size_t committed = 0;
+    {
+        PropertyStore store(test_logger());
+        CHECK(store.open(log));
+        CHECK(store.update("/a", props("{ns:}v", "1"), NO_REMOVALS));
+        committed = file_size(log);
+        CHECK(store.update("/a", props("{ns:}v", "2"), NO_REMOVALS));
+    }
+    std::string full = read_file(log);
+
+    std::string flipped = full;
+    flipped[flipped.size() - 1] ^= 0x01;
+    write_file(log, flipped);
+    {
+        PropertyStore store(test_logger());
+        CHECK(store.open(log));
+        CHECK(get(store, "/a", "{ns:}v") == "1");
+        CHECK(file_size(log) == committed);
+    }
+
+    // 长度字段声称的记录比文件剩余部分还长
+    write_file(log, full.substr(0, committed) + std::string("\xff\xff\x00\x00garbage", 11));
+    {
+        PropertyStore store(test_logger());
+        CHECK(store.open(log));
+        CHECK(get(store, "/a", "{ns:}v") == "1");
+        CHECK(file_size(log) == committed);
+    }
+}
+
+TEST(rejects_foreign_files) {
+    TempDir dir;
+    std::string log = dir.file("props.log");
+    write_file(log, "not a property store");
+    PropertyStore store(test_logger());
+    CHECK(!store.open(log));
+    CHECK(!store.is_open());
+    CHECK(!store.update("/a", props("{ns:}v", "1"), NO_REMOVALS));
+    CHECK(read_file(log) == "not a property store");
+}
+
+// 反复覆盖同一属性使日志膨胀到触发压缩；压缩期间其他线程的修改不丢失，重新打开后结果一致
+TEST(compaction_keeps_concurrent_updates) {
+    TempDir dir;
+    std::string log = dir.file("props.log");
+    const std::string big(64 * 1024, 'x');
+    const int THREADS = 4;
+    const int ROUNDS = 40;
+    {
+        PropertyStore store(test_logger());
+        CHECK(store.open(log));
+        std::vector<std::thread> writers;
+        for (int t = 0; t < THREADS; ++t) {
+            writers.emplace_back([&store, &big, t]() {
+                std::string path = "/file" + std::to_string(t);
+                for (int i = 0; i < ROUNDS; ++i) {
+                    CHECK(store.update(path, props("{ns:}v", big + std::to_string(i)), NO_REMOVALS));
+                    CHECK(store.update(path, props("{ns:}n", std::to_string(i)), NO_REMOVALS));
+                }
+            });
+        }
+        for (auto& writer : writers) {
+            writer.join();
+        }
+        // 未压缩时日志约为 THREADS * ROUNDS * 64KB
+        CHECK(file_size(log) < static_cast<size_t>(THREADS * ROUNDS / 2) * big.size());
+        for (int t = 0; t < THREADS; ++t) {
+            CHECK(get(store, "/file" + std::to_string(t), "{ns:}n") == std::to_string(ROUNDS - 1));
+        }
+    }
+
+    PropertyStore store(test_logger());
+    CHECK(store.open(log));
+    for (int t = 0; t < THREADS; ++t) {
+        std::string path = "/file" + std::to_string(t);
+        CHECK(get(store, path, "{ns:}v") == big + std::to_string(ROUNDS - 1));
+        CHECK(get(store, path, "{ns:}n") == std::to_string(ROUNDS - 1));
+    }
+    CHECK(file_size(dir.file("props.log.tmp")) == 0);
+}
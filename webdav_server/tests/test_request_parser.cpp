@@ -0,0 +1,153 @@
+#include "test_support.h"
+#include "request_parser.h"
+
+#include <string>
+
+using namespace webdav;
+
+namespace {
+
+const std::string SIMPLE_REQUEST =
+    "PROPFIND /dir/file.txt HTTP/1.1\r\n"
+    "Host: example.com\r\n"
+    "Depth:   1  \r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+
+std::string header(const RequestParser& parser, const std::string& buffer, const char* name) {
+    StringView value;
+    return parser.find_header(buffer.data(), name, value) ? value.str() : std::string("<missing>");
+}
+
+} // namespace
+
+// 数据在任意位置被切开（包括 \r 和 \n 之间）时，续传解析的结果与一次解析相同
+TEST(split_at_every_position) {
+    for (size_t split = 1; split < SIMPLE_REQUEST.size(); ++split) {
+        RequestParser parser;
+        CHECK(parser.parse(SIMPLE_REQUEST.data(), split) == RequestParser::Status::INCOMPLETE);
+        CHECK(parser.parse(SIMPLE_REQUEST.data(), SIMPLE_REQUEST.size()) == RequestParser::Status::COMPLETE);
+        CHECK(parser.header_size() == SIMPLE_REQUEST.size());
+        CHECK(parser.method() == HTTPMethod::PROPFIND);
+        CHECK(parser.uri(SIMPLE_REQUEST.data()).str() == "/dir/file.txt");
+        CHECK(parser.version(SIMPLE_REQUEST.data()).str() == "HTTP/1.1");
+        CHECK(parser.header_count() == 3);
+        CHECK(header(parser, SIMPLE_REQUEST, "depth") == "1");
+    }
+}
+
+// 逐字节到达：每次只多一个字节
+TEST(byte_by_byte) {
+    RequestParser parser;
+    for (size_t size = 1; size < SIMPLE_REQUEST.size(); ++size) {
+        CHECK(parser.parse(SIMPLE_REQUEST.data(), size) == RequestParser::Status::INCOMPLETE);
+    }
+    CHECK(parser.parse(SIMPLE_REQUEST.data(), SIMPLE_REQUEST.size()) == RequestParser::Status::COMPLETE);
+    CHECK(header(parser, SIMPLE_REQUEST, "Host") == "example.com");
+}
+
+// 流水线：解析在第一个请求头结束处停下，丢弃它之后从下一个请求开头继续，
+// 缓冲区中不完整的最后一个请求保持 INCOMPLETE
+TEST(pipelined_requests) {
+    std::string buffer =
+        "GET /a HTTP/1.1\r\nHost: x\r\n\r\n"
+        "PUT /b HTTP/1.1\r\nHost: x\r\nContent-Length: 3\r\n\r\nabc"
+        "DELETE /c HTTP/1.1\r\nHo";
+
+    RequestParser parser;
+    CHECK(parser.parse(buffer.data(), buffer.size()) == RequestParser::Status::COMPLETE);
+    CHECK(parser.method() == HTTPMethod::GET);
+    CHECK(parser.uri(buffer.data()).str() == "/a");
+    CHECK(buffer.compare(parser.header_size(), 3, "PUT") == 0);
+
+    buffer.erase(0, parser.header_size());
+    parser.reset();
+    CHECK(parser.parse(buffer.data(), buffer.size()) == RequestParser::Status::COMPLETE);
+    CHECK(parser.method() == HTTPMethod::PUT);
+    CHECK(header(parser, buffer, "Content-Length") == "3");
+    CHECK(buffer.compare(parser.header_size(), 3, "abc") == 0);
+
+    buffer.erase(0, parser.header_size() + 3);
+    parser.reset();
+    CHECK(parser.parse(buffer.data(), buffer.size()) == RequestParser::Status::INCOMPLETE);
+    buffer += "st: x\r\n\r\n";
+    CHECK(parser.parse(buffer.data(), buffer.size()) == RequestParser::Status::COMPLETE);
+    CHECK(parser.method() == HTTPMethod::DELETE);
+    CHECK(parser.header_size() == buffer.size());
+}
+
+// 只有 \n 的行尾也接受；请求行之前的空行忽略
+TEST(bare_line_feeds) {
+    std::string buffer = "\r\nGET / HTTP/1.0\nHost: x\n\n";
+    RequestParser parser;
+    CHECK(parser.parse(buffer.data(), buffer.size()) == RequestParser::Status::COMPLETE);
+    CHECK(parser.version(buffer.data()).str() == "HTTP/1.0");
+    CHECK(header(parser, buffer, "host") == "x");
+}
+
+TEST(malformed_headers) {
+    const char* inputs[] = {
+        "GET / HTTP/1.1\r\nHost: x\r\n continued\r\n\r\n",   // 折行
+        "GET / HTTP/1.1\r\nBad Name: x\r\n\r\n",
+        "GET / HTTP/1.1\rHost: x\r\n\r\n",
+        "G(T / HTTP/1.1\r\n\r\n",
+        "GET / HTTP/1.1\r\nHost: x\r\r\n\r\n"
+    };
+    for (const char* input : inputs) {
+        RequestParser parser;
+        CHECK(parser.parse(input, strlen(input)) == RequestParser::Status::ERROR);
+    }
+}
+
+TEST(too_many_headers) {
+    std::string buffer = "GET / HTTP/1.1\r\n";
+    for (size_t i = 0; i <= RequestParser::MAX_HEADERS; ++i) {
+        buffer += "X-" + std::to_string(i) + ": v\r\n";
+    }
+    buffer += "\r\n";
+    RequestParser parser;
+    CHECK(parser.parse(buffer.data(), buffer.size()) == RequestParser::Status::ERROR);
+}
+
+// 同名头部取最后一个；取值不同的重复头部可被识别出来
+TEST(duplicate_headers) {
+    std::string buffer =
+        "PUT /f HTTP/1.1\r\n"
+        "Content-Length: 5\r\n"
+        "content-length: 5\r\n"
+        "Transfer-Encoding: gzip\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n";
+    RequestParser parser;
+    CHECK(parser.parse(buffer.data(), buffer.size()) == RequestParser::Status::COMPLETE);
+    CHECK(header(parser, buffer, "Transfer-Encoding") == "chunked");
+    CHECK(!parser.has_conflicting_header(buffer.data(), "Content-Length"));
+    CHECK(parser.has_conflicting_header(buffer.data(), "Transfer-Encoding"));
+    CHECK(!parser.has_conflicting_header(buffer.data(), "Host"));
+
+    HTTPRequest request;
+    parser.to_request(buffer.data(), request);
+    HeaderMap::const_iterator it = request.headers.find("TRANSFER-ENCODING");
+    CHECK(it != request.headers.end() && it->second == "chunked");
+}
+
+// 同一 HTTPRequest 依次接收两个请求：后一个请求看不到前一个请求的头部
+TEST(request_reuse) {
+    std::string first = "GET /a HTTP/1.1\r\nHost: x\r\nRange: bytes=0-1\r\nExpect: 100-continue\r\n\r\n";
+    std::string second = "GET /b HTTP/1.1\r\nHost: y\r\n\r\n";
+
+    HTTPRequest request;
+    RequestParser parser;
+    CHECK(parser.parse(first.data(), first.size()) == RequestParser::Status::COMPLETE);
+    parser.to_request(first.data(), request);
+    CHECK(request.headers.size() == 3);
+
+    request.clear();
+    parser.reset();
+    CHECK(parser.parse(second.data(), second.size()) == RequestParser::Status::COMPLETE);
+    parser.to_request(second.data(), request);
+    CHECK(request.uri == "/b");
+    CHECK(request.headers.size() == 1);
+    CHECK(request.headers.find("Range") == request.headers.end());
+    CHECK(request.headers.find("Host")->second == "y");
+}
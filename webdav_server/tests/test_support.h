@@ -0,0 +1,82 @@
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// 单元测试的最小支撑：TEST 定义并注册用例，CHECK 失败时打印位置后继续执行，
+// test_main.cpp 依次运行全部用例，有失败时返回非零，由 ctest 判定
+namespace webdav {
+namespace test {
+
+struct TestCase {
+    const char* name;
+    void (*run)();
+};
+
+inline std::vector<TestCase>& registry() {
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+struct Registrar {
+    Registrar(const char* name, void (*run)()) {
+        registry().push_back(TestCase{name, run});
+    }
+};
+
+// 用例独占的临时目录，析构时连同内容一起删除
+class TempDir {
+public:
+    TempDir() {
+        const char* base = std::getenv("TMPDIR");
+        std::string pattern = std::string(base && *base ? base : "/tmp") + "/webdav_test_XXXXXX";
+        std::vector<char> name(pattern.begin(), pattern.end());
+        name.push_back('\0');
+        if (mkdtemp(name.data())) {
+            path_ = name.data();
+        }
+    }
+    ~TempDir() {
+        if (!path_.empty()) {
+            std::string command = "rm -rf '" + path_ + "'";
+            if (std::system(command.c_str()) != 0) {
+                std::fprintf(stderr, "failed to remove %s\n", path_.c_str());
+            }
+        }
+    }
+
+    const std::string& path() const { return path_; }
+    std::string file(const std::string& name) const { return path_ + "/" + name; }
+
+private:
+    TempDir(const TempDir&);
+    TempDir& operator=(const TempDir&);
+
+    std::string path_;
+};
+
+} // namespace test
+} // namespace webdav
+
+#define TEST(name) \
+    static void name(); \
+    static ::webdav::test::Registrar name##_registrar(#name, name); \
+    static void name()
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            ++::webdav::test::failures(); \
+        } \
+    } while (0)
+
+#endif // TEST_SUPPORT_H
@@ -0,0 +1,238 @@
+#include "test_support.h"
+#include "tree_walker.h"
+
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace webdav;
+using webdav::test::TempDir;
+
+namespace {
+
+typedef std::vector<std::pair<std::string, int>> Walk;   // (相对路径, 层级)
+
+void make_file(const std::string& path) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    CHECK(fd >= 0);
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+void make_dir(const std::string& path) {
+    CHECK(mkdir(path.c_str(), 0755) == 0);
+}
+
+// 以打乱的顺序创建条目，使目录的读取顺序与名称顺序无关：
+// 若干小目录、一个超过单个 stat 任务的大目录、一条很深的链、一个指向目录的符号链接，
+// 以及总数超过缓冲上限、需要暂缓读取的一批目录
+void build_tree(const std::string& root) {
+    const char* names[] = {"m", "b", "z", "a", "k"};
+    for (const char* name : names) {
+        make_dir(root + "/" + name);
+        for (int i = 9; i >= 0; --i) {
+            make_file(root + "/" + name + "/f" + std::to_string(i * 7 % 10));
+        }
+        make_dir(root + "/" + name + "/sub");
+        make_file(root + "/" + name + "/sub/leaf");
+    }
+
+    make_dir(root + "/big");
+    for (int i = 0; i < 700; ++i) {
+        make_file(root + "/big/e" + std::to_string((i * 337) % 700));
+    }
+
+    std::string deep = root + "/deep";
+    for (int i = 0; i < 40; ++i) {
+        make_dir(deep);
+        make_file(deep + "/x");
+        deep += "/d";
+    }
+
+    CHECK(symlink("m", (root + "/link").c_str()) == 0);
+
+    make_dir(root + "/wide");
+    for (int d = 19; d >= 0; --d) {
+        std::string dir = root + "/wide/w" + std::to_string(d);
+        make_dir(dir);
+        for (int i = 0; i < 1000; ++i) {
+            make_file(dir + "/" + std::to_string((i * 613) % 1000));
+        }
+    }
+}
+
+// 参照实现：单线程递归，名称按字节序排序，符号链接不进入
+void reference_walk(const std::string& root, const std::string& relative, int depth, int max_depth, Walk& out) {
+    if (depth > max_depth) {
+        return;
+    }
+    DIR* dir = opendir((root + relative).c_str());
+    if (!dir) {
+        return;
+    }
+    std::vector<std::string> names;
+    while (struct dirent* entry = readdir(dir)) {
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+            names.push_back(entry->d_name);
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+
+    for (const std::string& name : names) {
+        std::string path = relative + "/" + name;
+        out.push_back(std::make_pair(path, depth));
+        struct stat st;
+        if (lstat((root + path).c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+            reference_walk(root, path, depth + 1, max_depth, out);
+        }
+    }
+}
+
+Walk tree_walk(const std::string& root, int max_depth, size_t helpers, size_t stop_after = 0) {
+    std::atomic<int> permits(static_cast<int>(helpers));
+    int fd = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    CHECK(fd >= 0);
+    TreeWalker walker(fd, std::string(), max_depth, permits, helpers,
+                      [](const std::string& path, const struct stat& st, FileInfo& info) {
+                          info.path = path;
+                          info.name = path.substr(path.rfind('/') + 1);
+                          info.is_directory = S_ISDIR(st.st_mode);
+                          info.size = static_cast<size_t>(st.st_size);
+                      });
+    Walk out;
+    walker.run([&out, stop_after](const FileInfo& info, int depth) {
+        out.push_back(std::make_pair(info.path, depth));
+        return stop_after == 0 || out.size() < stop_after;
+    });
+    return out;
+}
+
+} // namespace
+
+// 任意辅助线程数下的遍历结果都与单线程参照实现完全相同，多次运行结果不变
+TEST(deterministic_preorder) {
+    TempDir dir;
+    build_tree(dir.path());
+
+    Walk expected;
+    reference_walk(dir.path(), std::string(), 1, 1000, expected);
+    CHECK(expected.size() > 20000);
+
+    const size_t helper_counts[] = {0, 1, 3, 8};
+    for (size_t helpers : helper_counts) {
+        for (int run = 0; run < 3; ++run) {
+            Walk walk = tree_walk(dir.path(), 1000, helpers);
+            CHECK(walk.size() == expected.size());
+            CHECK(walk == expected);
+        }
+    }
+}
+
+TEST(depth_limit) {
+    TempDir dir;
+    build_tree(dir.path());
+    for (int max_depth = 1; max_depth <= 3; ++max_depth) {
+        Walk expected;
+        reference_walk(dir.path(), std::string(), 1, max_depth, expected);
+        CHECK(tree_walk(dir.path(), max_depth, 4) == expected);
+    }
+    CHECK(tree_walk(dir.path(), 0, 4).empty());
+}
+
+// 回调返回 false 时立即结束，已交出的前缀与完整遍历一致
+TEST(early_stop) {
+    TempDir dir;
+    build_tree(dir.path());
+    Walk full = tree_walk(dir.path(), 1000, 4);
+    Walk partial = tree_walk(dir.path(), 1000, 4, 5000);
+    CHECK(partial.size() == 5000);
+    CHECK(std::equal(partial.begin(), partial.end(), full.begin()));
+}
+
+// 常驻辅助线程：每个下标恰好处理一次，并发的批量操作互不干扰
+TEST(helper_pool_covers_every_index) {
+    HelperPool pool(4);
+    for (size_t count : {0, 1, 31, 32, 33, 1000}) {
+        std::vector<std::atomic<int>> seen(count);
+        for (auto& value : seen) {
+            value = 0;
+        }
+        pool.parallel_for(count, 32, [&seen](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                seen[i]++;
+            }
+        });
+        for (auto& value : seen) {
+            CHECK(value == 1);
+        }
+    }
+
+    std::atomic<size_t> total(0);
+    std::vector<std::thread> callers;
+    for (int t = 0; t < 4; ++t) {
+        callers.emplace_back([&pool, &total]() {
+            for (int round = 0; round < 50; ++round) {
+                pool.parallel_for(100, 7, [&total](size_t begin, size_t end) {
+                    total += end - begin;
+                });
+            }
+        });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+    CHECK(total == 4 * 50 * 100);
+}
+
+// 无法读取的子目录交给错误回调且不进入，不当作空目录交给 visitor；其余条目照常遍历
+TEST(unreadable_directory_reported) {
+    TempDir dir;
+    make_dir(dir.file("a"));
+    make_file(dir.file("a/x"));
+    make_dir(dir.file("b"));
+    make_file(dir.file("b/y"));
+    make_dir(dir.file("c"));
+    make_file(dir.file("c/z"));
+    CHECK(chmod(dir.file("b").c_str(), 0) == 0);
+
+    // 有 CAP_DAC_OVERRIDE 时（以 root 运行）权限不起作用，无法构造出错的目录
+    int probe = open(dir.file("b").c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (probe >= 0) {
+        close(probe);
+        chmod(dir.file("b").c_str(), 0755);
+        return;
+    }
+
+    std::atomic<int> permits(2);
+    TreeWalker walker(open(dir.path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC), std::string(), 10,
+                      permits, 2,
+                      [](const std::string& path, const struct stat& st, FileInfo& info) {
+                          info.path = path;
+                          info.is_directory = S_ISDIR(st.st_mode);
+                      });
+    Walk visited;
+    Walk failed;
+    int error = 0;
+    walker.run([&visited](const FileInfo& info, int depth) {
+        visited.push_back(std::make_pair(info.path, depth));
+        return true;
+    }, [&failed, &error](const FileInfo& info, int depth, int code) {
+        failed.push_back(std::make_pair(info.path, depth));
+        error = code;
+        return true;
+    });
+    chmod(dir.file("b").c_str(), 0755);
+
+    CHECK(visited == Walk({{"/a", 1}, {"/a/x", 2}, {"/c", 1}, {"/c/z", 2}}));
+    CHECK(failed == Walk({{"/b", 1}}));
+    CHECK(error == EACCES);
+}